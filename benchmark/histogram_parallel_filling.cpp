@@ -9,6 +9,8 @@
 #include <boost/histogram/axis/regular.hpp>
 #include <boost/histogram/histogram.hpp>
 #include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/sharded_storage.hpp>
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <mutex>
@@ -30,6 +32,7 @@ using namespace std::chrono_literals;
 
 using DS = dense_storage<unsigned>;
 using DSTS = dense_storage<accumulators::thread_safe<unsigned>>;
+using SS = sharded_storage<unsigned>;
 
 static void NoThreads(benchmark::State& state) {
   std::default_random_engine gen(1);
@@ -65,6 +68,37 @@ static void AtomicStorage(benchmark::State& state) {
   }
 }
 
+static auto sharded_hist = make_histogram_with(SS(), axis::regular<>());
+
+static void ShardedStorage(benchmark::State& state) {
+  init.lock();
+  if (state.thread_index == 0) {
+    const unsigned nbins = state.range(0);
+    sharded_hist = make_histogram_with(SS(), axis::regular<>(nbins, 0, 1));
+  }
+  init.unlock();
+  std::default_random_engine gen(state.thread_index);
+  std::uniform_real_distribution<> dis(0, 1);
+  for (auto _ : state) {
+    // simulate some work
+    for (volatile unsigned n = 0; n < state.range(1); ++n)
+      ;
+    sharded_hist(dis(gen));
+  }
+}
+
+static void FillN(benchmark::State& state) {
+  std::default_random_engine gen(1);
+  std::uniform_real_distribution<> dis(0, 1);
+  const unsigned nbins = state.range(0);
+  const unsigned nthreads = state.range(1);
+  auto hist = make_histogram_with(dense_storage<double>(), axis::regular<>(nbins, 0, 1));
+  std::vector<double> x(1 << 20);
+  std::generate(x.begin(), x.end(), [&] { return dis(gen); });
+  for (auto _ : state) hist.fill(x, threads(nthreads));
+  state.SetItemsProcessed(state.iterations() * x.size());
+}
+
 BENCHMARK(NoThreads)
     ->UseRealTime()
 
@@ -147,3 +181,42 @@ BENCHMARK(AtomicStorage)
     ->Args({1 << 18, 100})
 
     ;
+
+BENCHMARK(ShardedStorage)
+    ->UseRealTime()
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+
+    ->Args({1 << 4, 0})
+    ->Args({1 << 6, 0})
+    ->Args({1 << 8, 0})
+    ->Args({1 << 10, 0})
+    ->Args({1 << 14, 0})
+    ->Args({1 << 18, 0})
+
+    ->Args({1 << 4, 5})
+    ->Args({1 << 6, 5})
+    ->Args({1 << 8, 5})
+    ->Args({1 << 10, 5})
+    ->Args({1 << 14, 5})
+    ->Args({1 << 18, 5})
+
+    ;
+
+BENCHMARK(FillN)
+    ->UseRealTime()
+
+    ->Args({1 << 4, 1})
+    ->Args({1 << 10, 1})
+    ->Args({1 << 18, 1})
+
+    ->Args({1 << 4, 2})
+    ->Args({1 << 10, 2})
+    ->Args({1 << 18, 2})
+
+    ->Args({1 << 4, 4})
+    ->Args({1 << 10, 4})
+    ->Args({1 << 18, 4})
+
+    ;
@@ -16,21 +16,30 @@
     - [boost/histogram/axis/ostream.hpp][2]
     - [boost/histogram/accumulators/ostream.hpp][3]
     - [boost/histogram/serialization.hpp][4]
+    - [boost/histogram/mapped_storage.hpp][5]
 
   [1]: histogram/reference.html#header.boost.histogram.ostream_hpp
   [2]: histogram/reference.html#header.boost.histogram.axis.ostream_hpp
   [3]: histogram/reference.html#header.boost.histogram.accumulators.ostream_hpp
   [4]: histogram/reference.html#header.boost.histogram.serialization_hpp
+  [5]: histogram/reference.html#header.boost.histogram.mapped_storage_hpp
 */
 
 #include <boost/histogram/accumulators.hpp>
 #include <boost/histogram/algorithm.hpp>
 #include <boost/histogram/axis.hpp>
+#include <boost/histogram/blocked_unlimited_storage.hpp>
+#include <boost/histogram/double_buffered_storage.hpp>
 #include <boost/histogram/histogram.hpp>
 #include <boost/histogram/indexed.hpp>
 #include <boost/histogram/literals.hpp>
 #include <boost/histogram/make_histogram.hpp>
 #include <boost/histogram/make_profile.hpp>
+#include <boost/histogram/paged_storage.hpp>
+#include <boost/histogram/quantile_storage.hpp>
+#include <boost/histogram/sharded_storage.hpp>
+#include <boost/histogram/soa_storage.hpp>
+#include <boost/histogram/sparse_storage.hpp>
 #include <boost/histogram/storage_adaptor.hpp>
 #include <boost/histogram/unlimited_storage.hpp>
 
@@ -17,8 +17,10 @@
   [1]: histogram/reference.html#header.boost.histogram.accumulators.ostream_hpp
 */
 
+#include <boost/histogram/accumulators/bootstrap.hpp>
 #include <boost/histogram/accumulators/count.hpp>
 #include <boost/histogram/accumulators/mean.hpp>
+#include <boost/histogram/accumulators/quantile_sketch.hpp>
 #include <boost/histogram/accumulators/sum.hpp>
 #include <boost/histogram/accumulators/thread_safe.hpp>
 #include <boost/histogram/accumulators/weighted_mean.hpp>
@@ -0,0 +1,165 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_ACCUMULATORS_BOOTSTRAP_HPP
+#define BOOST_HISTOGRAM_ACCUMULATORS_BOOTSTRAP_HPP
+
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/fwd.hpp> // for bootstrap<>
+#include <cstddef>
+#include <cstdint>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+// finalizer of splitmix64, a fast hash with good avalanche properties
+inline std::uint64_t splitmix64(std::uint64_t z) noexcept {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+  return z ^ (z >> 31);
+}
+
+// draw from Poisson distribution with mean 1 by inversion of the cumulative distribution
+// function, u is uniform in [0, 2^32); the comparisons have no branches and the loops
+// over the replicas can be vectorized
+inline unsigned poisson_one(const std::uint32_t u) noexcept {
+  // round(cdf(k) * 2^32) for k = 0, ..., 11, all larger values round to 2^32
+  constexpr std::uint32_t cdf[] = {1580030169u, 3160060337u, 3950075422u, 4213413783u,
+                                   4279248374u, 4292415292u, 4294609778u, 4294923276u,
+                                   4294962463u, 4294966817u, 4294967253u, 4294967292u};
+  unsigned k = 0;
+  for (auto c : cdf) k += u >= c;
+  return k;
+}
+
+// weight of a replica for the hash of an event
+inline unsigned poisson_one(const std::uint64_t key, const std::size_t replica) noexcept {
+  const auto r = static_cast<std::uint64_t>(replica) + 1;
+  return poisson_one(
+      static_cast<std::uint32_t>(splitmix64(key + r * 0x9e3779b97f4a7c15u) >> 32));
+}
+
+} // namespace detail
+
+namespace accumulators {
+
+/** Sum of weights with Poisson bootstrap replicas.
+
+  The bootstrap estimates the uncertainty of a quantity computed from a histogram by
+  computing the same quantity from replicas of the histogram, in which each event has a
+  random weight drawn from a Poisson distribution with mean 1. The spread of the results
+  estimates the uncertainty. This accumulator holds the nominal sum of weights and the
+  sums of all replicas in one cell, so the index of the cell is computed only once per
+  event, and all replicas are updated in a loop which the compiler can vectorize.
+
+  The event number is passed as the sample, `h(x, sample(event))`. The Poisson weights
+  are computed from the event number with a hash, so an event gets the same weights in
+  all histograms and correlations between histograms are kept. Events must therefore
+  have unique numbers, but they may be filled in any order and by any thread.
+
+  @tparam ValueType type of the sums.
+  @tparam Replicas number of bootstrap replicas.
+*/
+template <class ValueType, std::size_t Replicas>
+class bootstrap {
+  static_assert(Replicas > 1, "Replicas must be larger than one");
+
+public:
+  using value_type = ValueType;
+  using const_reference = const value_type&;
+
+  bootstrap() = default;
+
+  /// Insert event with weight 1.
+  void operator()(const std::uint64_t& event) noexcept { add(value_type{1}, event); }
+
+  /// Insert event with weight w.
+  void operator()(const weight_type<value_type>& w, const std::uint64_t& event) noexcept {
+    add(w.value, event);
+  }
+
+  /// Add another bootstrap accumulator, the events must be disjoint.
+  bootstrap& operator+=(const bootstrap& rhs) noexcept {
+    value_ += rhs.value_;
+    for (std::size_t i = 0; i < Replicas; ++i) replicas_[i] += rhs.replicas_[i];
+    return *this;
+  }
+
+  /// Scale by value.
+  bootstrap& operator*=(const_reference s) noexcept {
+    value_ *= s;
+    for (auto&& x : replicas_) x *= s;
+    return *this;
+  }
+
+  bool operator==(const bootstrap& rhs) const noexcept {
+    if (value_ != rhs.value_) return false;
+    for (std::size_t i = 0; i < Replicas; ++i)
+      if (replicas_[i] != rhs.replicas_[i]) return false;
+    return true;
+  }
+
+  bool operator!=(const bootstrap& rhs) const noexcept { return !operator==(rhs); }
+
+  /// Return nominal sum of weights.
+  const_reference value() const noexcept { return value_; }
+
+  /// Return variance of the sum of weights, estimated from the replicas.
+  value_type variance() const noexcept {
+    value_type mean = 0;
+    for (auto&& x : replicas_) mean += x;
+    mean /= Replicas;
+    value_type sum = 0;
+    for (auto&& x : replicas_) sum += (x - mean) * (x - mean);
+    return sum / (Replicas - 1);
+  }
+
+  /// Return number of replicas.
+  static constexpr std::size_t size() noexcept { return Replicas; }
+
+  /// Return sum of weights of replica i.
+  const_reference operator[](std::size_t i) const noexcept {
+    BOOST_ASSERT(i < Replicas);
+    return replicas_[i];
+  }
+
+  /**
+    Return Poisson weight of an event in a replica.
+
+    The weights are the same for all accumulators with the same number of replicas.
+
+    @param event event number.
+    @param replica index of the replica.
+  */
+  static unsigned poisson_weight(std::uint64_t event, std::size_t replica) noexcept {
+    return detail::poisson_one(detail::splitmix64(event), replica);
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    ar& make_nvp("value", value_);
+    for (auto&& x : replicas_) ar& make_nvp("replica", x);
+  }
+
+private:
+  void add(const value_type w, const std::uint64_t event) noexcept {
+    value_ += w;
+    const auto key = detail::splitmix64(event);
+    for (std::size_t i = 0; i < Replicas; ++i)
+      replicas_[i] += w * static_cast<value_type>(detail::poisson_one(key, i));
+  }
+
+  value_type value_{};
+  value_type replicas_[Replicas] = {};
+};
+
+} // namespace accumulators
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -56,14 +56,25 @@ public:
     sum_of_deltas_squared_ += w.value * delta * (x - mean_);
   }
 
-  /// Add another mean accumulator
+  /** Add another mean accumulator
+
+   Uses the parallel algorithm of Chan et al., which adds the spread of the two means
+   to the sum of squared deltas.
+  */
   mean& operator+=(const mean& rhs) noexcept {
-    if (sum_ != 0 || rhs.sum_ != 0) {
-      const auto tmp = mean_ * sum_ + rhs.mean_ * rhs.sum_;
-      sum_ += rhs.sum_;
-      mean_ = tmp / sum_;
+    // copy rhs first, it may be *this
+    const auto n2 = rhs.sum_;
+    const auto m2 = rhs.mean_;
+    const auto d2 = rhs.sum_of_deltas_squared_;
+    if (sum_ != 0 || n2 != 0) {
+      const auto n1 = sum_;
+      const auto m1 = mean_;
+      sum_ += n2;
+      mean_ = (m1 * n1 + m2 * n2) / sum_;
+      sum_of_deltas_squared_ +=
+          n1 * (mean_ - m1) * (mean_ - m1) + n2 * (mean_ - m2) * (mean_ - m2);
     }
-    sum_of_deltas_squared_ += rhs.sum_of_deltas_squared_;
+    sum_of_deltas_squared_ += d2;
     return *this;
   }
 
@@ -108,6 +119,8 @@ public:
   }
 
 private:
+  friend struct ::boost::histogram::unsafe_access;
+
   value_type sum_{};
   value_type mean_{};
   value_type sum_of_deltas_squared_{};
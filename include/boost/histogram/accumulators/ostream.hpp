@@ -91,6 +91,23 @@ std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>&
   return detail::handle_nonzero_width(os, x);
 }
 
+template <class CharT, class Traits, class U, std::size_t N>
+std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& os,
+                                              const bootstrap<U, N>& x) {
+  if (os.width() == 0)
+    return os << "bootstrap(" << x.value() << ", " << x.variance() << ")";
+  return detail::handle_nonzero_width(os, x);
+}
+
+template <class CharT, class Traits, class U>
+std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& os,
+                                              const quantile_sketch<U>& x) {
+  if (os.width() == 0)
+    return os << "quantile_sketch(" << x.count() << ", " << x.min() << ", " << x.max()
+              << ")";
+  return detail::handle_nonzero_width(os, x);
+}
+
 template <class CharT, class Traits, class T>
 std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& os,
                                               const thread_safe<T>& x) {
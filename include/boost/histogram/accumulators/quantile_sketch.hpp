@@ -0,0 +1,239 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_ACCUMULATORS_QUANTILE_SKETCH_HPP
+#define BOOST_HISTOGRAM_ACCUMULATORS_QUANTILE_SKETCH_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/fwd.hpp> // for quantile_sketch<>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+template <class T>
+struct centroid {
+  T mean;
+  T weight;
+
+  bool operator==(const centroid& o) const noexcept {
+    return mean == o.mean && weight == o.weight;
+  }
+};
+
+// number of centroids at which a t-digest is compressed, a multiple of 16 so that the
+// buffer fills whole blocks of quantile_storage
+template <class T>
+std::size_t tdigest_capacity(const T compression) noexcept {
+  const auto n = static_cast<std::size_t>(std::ceil(compression));
+  return std::max<std::size_t>(16, (n + 15) / 16 * 16);
+}
+
+/*
+  Sorts the centroids by mean and merges neighbours, as in the merging t-digest of
+  Dunning and Ertl. The weight of each centroid is limited by the k1 scale function,
+  k(q) = compression / (2 pi) asin(2 q - 1), so that each centroid covers at most one
+  unit of k. Centroids near q = 0 and q = 1 stay small, which makes extreme quantiles
+  accurate, and at most about compression / 2 centroids remain. Returns the new number
+  of centroids.
+*/
+template <class T>
+std::size_t tdigest_compress(centroid<T>* c, const std::size_t n, const T compression) {
+  if (n < 2) return n;
+  std::sort(c, c + n, [](const centroid<T>& a, const centroid<T>& b) {
+    return a.mean < b.mean;
+  });
+  T total = 0;
+  for (auto it = c; it != c + n; ++it) total += it->weight;
+  const T pi = static_cast<T>(3.14159265358979323846);
+  // largest cumulative weight which the centroid starting at weight w may reach
+  auto limit = [&](const T w) {
+    const T q = std::min(T{1}, 2 * w / total - 1);
+    const T k = compression / (2 * pi) * std::asin(q) + 1;
+    if (k >= compression / 4) return total;
+    return total * (std::sin(2 * pi * k / compression) + 1) / 2;
+  };
+  std::size_t m = 0;
+  T before = 0;
+  T lim = limit(before);
+  for (std::size_t i = 1; i < n; ++i) {
+    if (before + c[m].weight + c[i].weight <= lim) {
+      c[m].weight += c[i].weight;
+      c[m].mean += (c[i].mean - c[m].mean) * c[i].weight / c[m].weight;
+    } else {
+      before += c[m].weight;
+      lim = limit(before);
+      c[++m] = c[i];
+    }
+  }
+  return m + 1;
+}
+
+// interpolates linearly between the centers of sorted centroids, and between the
+// outermost centroids and the minimum and maximum
+template <class T>
+T tdigest_quantile(const centroid<T>* c, const std::size_t n, const T total,
+                   const T min, const T max, const T q) noexcept {
+  BOOST_ASSERT(q >= 0 && q <= 1);
+  if (n == 0) return std::numeric_limits<T>::quiet_NaN();
+  const T t = q * total;
+  T before = 0, left = 0, left_value = min;
+  for (auto it = c; it != c + n; ++it) {
+    const T center = before + it->weight / 2;
+    if (t < center) {
+      if (center == left) return it->mean;
+      return left_value + (it->mean - left_value) * (t - left) / (center - left);
+    }
+    left = center;
+    left_value = it->mean;
+    before += it->weight;
+  }
+  if (total == left) return max;
+  return left_value + (max - left_value) * (t - left) / (total - left);
+}
+
+} // namespace detail
+
+namespace accumulators {
+
+/** Mergeable estimate of the quantiles of a sample.
+
+  The sample is summarized by a t-digest, a list of centroids which hold the mean and
+  the sum of weights of neighbouring values. Centroids near the lower and upper end of
+  the distribution are kept small, so extreme quantiles like the 99th percentile are
+  estimated accurately. The minimum and maximum are exact. New values are appended to
+  a buffer, which is sorted and merged when it is full. The memory is bounded by the
+  compression parameter, larger values are more accurate and use more memory.
+
+  Sketches can be added, the result estimates the quantiles of the union of the samples.
+  To fill many sketches without allocating memory for each of them, use the
+  quantile_storage.
+*/
+template <class ValueType>
+class quantile_sketch {
+public:
+  using value_type = ValueType;
+  using const_reference = const value_type&;
+
+  quantile_sketch() = default;
+
+  /// Initialize with compression parameter.
+  explicit quantile_sketch(const_reference compression) : compression_(compression) {
+    BOOST_ASSERT(compression > 0);
+  }
+
+  /// Insert sample x.
+  void operator()(const_reference x) { add(x, static_cast<value_type>(1)); }
+
+  /// Insert sample x with weight w.
+  void operator()(const weight_type<value_type>& w, const_reference x) {
+    add(x, w.value);
+  }
+
+  /// Add another sketch.
+  quantile_sketch& operator+=(const quantile_sketch& rhs) {
+    if (rhs.count_ == 0) return *this;
+    // push() may compress the centroids of rhs if it is *this
+    if (&rhs == this) return operator+=(quantile_sketch(rhs));
+    count_ += rhs.count_;
+    min_ = std::min(min_, rhs.min_);
+    max_ = std::max(max_, rhs.max_);
+    for (auto&& c : rhs.centroids_) push(c);
+    return *this;
+  }
+
+  /// Scale the weights by value.
+  quantile_sketch& operator*=(const_reference s) noexcept {
+    count_ *= s;
+    for (auto&& c : centroids_) c.weight *= s;
+    return *this;
+  }
+
+  bool operator==(const quantile_sketch& rhs) const noexcept {
+    return compression_ == rhs.compression_ && count_ == rhs.count_ &&
+           (count_ == 0 || (min_ == rhs.min_ && max_ == rhs.max_)) &&
+           centroids_ == rhs.centroids_;
+  }
+
+  bool operator!=(const quantile_sketch& rhs) const noexcept { return !operator==(rhs); }
+
+  /// Return sum of weights.
+  const_reference count() const noexcept { return count_; }
+
+  /// Return smallest sample.
+  const_reference min() const noexcept { return min_; }
+
+  /// Return largest sample.
+  const_reference max() const noexcept { return max_; }
+
+  /// Return compression parameter.
+  const_reference compression() const noexcept { return compression_; }
+
+  /**
+    Return estimated quantile.
+
+    Returns NaN if the sketch is empty.
+
+    @param q probability in [0, 1].
+  */
+  value_type quantile(const_reference q) const {
+    auto c = centroids_;
+    const auto n = detail::tdigest_compress(c.data(), c.size(), compression_);
+    return detail::tdigest_quantile(c.data(), n, count_, min_, max_, q);
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    ar& make_nvp("compression", compression_);
+    ar& make_nvp("count", count_);
+    ar& make_nvp("min", min_);
+    ar& make_nvp("max", max_);
+    std::size_t size = centroids_.size();
+    ar& make_nvp("size", size);
+    centroids_.resize(size);
+    for (auto&& c : centroids_) {
+      ar& make_nvp("mean", c.mean);
+      ar& make_nvp("weight", c.weight);
+    }
+  }
+
+private:
+  template <class T, class A>
+  friend class ::boost::histogram::quantile_storage;
+
+  void add(const value_type x, const value_type w) {
+    if (w == 0) return;
+    count_ += w;
+    min_ = std::min(min_, x);
+    max_ = std::max(max_, x);
+    push({x, w});
+  }
+
+  void push(const detail::centroid<value_type>& c) {
+    centroids_.push_back(c);
+    if (centroids_.size() >= detail::tdigest_capacity(compression_))
+      centroids_.resize(
+          detail::tdigest_compress(centroids_.data(), centroids_.size(), compression_));
+  }
+
+  value_type compression_ = 100;
+  value_type count_{};
+  value_type min_ = std::numeric_limits<value_type>::infinity();
+  value_type max_ = -std::numeric_limits<value_type>::infinity();
+  std::vector<detail::centroid<value_type>> centroids_;
+};
+
+} // namespace accumulators
+} // namespace histogram
+} // namespace boost
+
+#endif
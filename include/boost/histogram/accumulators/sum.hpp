@@ -25,6 +25,10 @@ namespace accumulators {
   accumulate a sum, but the relative error of the sum is at the level of the machine
   precision, independent of the number of samples.
 
+  Weighted fills of a histogram with histogram::fill() are faster. If the chunk of values
+  is large compared to the number of cells, consecutive weights are added to several
+  compensated partial sums for each cell, which are then added to the cell.
+
   A. Neumaier, Zeitschrift fuer Angewandte Mathematik und Mechanik 54 (1974) 39-51.
 */
 template <class ValueType>
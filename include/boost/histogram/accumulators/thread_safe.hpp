@@ -9,23 +9,136 @@
 
 #include <atomic>
 #include <boost/core/nvp.hpp>
+#include <boost/histogram/accumulators/mean.hpp>
+#include <boost/histogram/accumulators/weighted_mean.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
+#include <boost/histogram/fwd.hpp>
 #include <boost/mp11/utility.hpp>
 #include <type_traits>
+#include <utility>
 
 namespace boost {
 namespace histogram {
+namespace detail {
+
+// compare-and-swap loop for updates which std::atomic<T> does not provide, like
+// fetch_add for floating point numbers before C++20
+template <class T, class F>
+void atomic_update(std::atomic<T>& a, F f) noexcept {
+  T old = a.load(std::memory_order_relaxed);
+  while (!a.compare_exchange_weak(old, f(old), std::memory_order_relaxed)) {}
+}
+
+// lock of an accumulator which updates several numbers together; a spin lock is
+// cheaper than a mutex here, because the lock is held only for a few instructions
+class spin_lock_guard {
+public:
+  explicit spin_lock_guard(std::atomic_flag& f) noexcept : f_(f) {
+    while (f_.test_and_set(std::memory_order_acquire)) {}
+  }
+  ~spin_lock_guard() noexcept { f_.clear(std::memory_order_release); }
+
+  spin_lock_guard(const spin_lock_guard&) = delete;
+  spin_lock_guard& operator=(const spin_lock_guard&) = delete;
+
+private:
+  std::atomic_flag& f_;
+};
+
+// base of thread-safe adaptors for accumulators whose state cannot be updated with
+// independent atomic operations
+template <class Derived, class Accumulator>
+class locked_accumulator {
+public:
+  using accumulator_type = Accumulator;
+  using value_type = typename Accumulator::value_type;
+
+  locked_accumulator() = default;
+  locked_accumulator(const accumulator_type& x) noexcept : acc_(x) {}
+  locked_accumulator(const locked_accumulator& o) noexcept : acc_(o.load()) {}
+  locked_accumulator& operator=(const locked_accumulator& o) noexcept {
+    store(o.load());
+    return *this;
+  }
+
+  /// Return copy of the adapted accumulator.
+  accumulator_type load() const noexcept {
+    spin_lock_guard g(lock_);
+    return acc_;
+  }
+
+  /// Replace the adapted accumulator.
+  void store(const accumulator_type& x) noexcept {
+    spin_lock_guard g(lock_);
+    acc_ = x;
+  }
+
+  // not templates, so that accumulator_traits can detect the arguments
+  /// Insert sample x.
+  void operator()(const value_type& x) {
+    spin_lock_guard g(lock_);
+    acc_(x);
+  }
+
+  /// Insert sample x with weight w.
+  void operator()(const weight_type<value_type>& w, const value_type& x) {
+    spin_lock_guard g(lock_);
+    acc_(w, x);
+  }
+
+  Derived& operator+=(const accumulator_type& x) {
+    spin_lock_guard g(lock_);
+    acc_ += x;
+    return static_cast<Derived&>(*this);
+  }
+
+  Derived& operator+=(const locked_accumulator& o) { return operator+=(o.load()); }
+
+  Derived& operator*=(const value_type& x) {
+    spin_lock_guard g(lock_);
+    acc_ *= x;
+    return static_cast<Derived&>(*this);
+  }
+
+  bool operator==(const locked_accumulator& o) const noexcept {
+    return load() == o.load();
+  }
+  bool operator!=(const locked_accumulator& o) const noexcept { return !operator==(o); }
+
+  /// Return mean of accumulated samples.
+  value_type value() const noexcept { return load().value(); }
+
+  /// Return variance of accumulated samples.
+  value_type variance() const { return load().variance(); }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    auto value = load();
+    ar& make_nvp("value", value);
+    store(value);
+  }
+
+private:
+  mutable std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+  accumulator_type acc_;
+};
+
+} // namespace detail
+
 namespace accumulators {
 
 /** Thread-safe adaptor for builtin integral and floating point numbers.
 
   This adaptor uses std::atomic to make concurrent increments and additions safe for the
-  stored value.
+  stored value. Floating point numbers are added with a compare-and-swap loop.
 
   On common computing platforms, the adapted integer has the same size and
   alignment as underlying type. The atomicity is implemented with a special CPU
   instruction. On exotic platforms the size of the adapted number may be larger and/or the
   type may have different alignment, which means it cannot be tightly packed into arrays.
 
+  There are specializations for weighted_sum, mean, and weighted_mean.
+
   @tparam T type to adapt, must be supported by std::atomic.
  */
 template <class T>
@@ -53,7 +166,7 @@ public:
     return *this;
   }
   thread_safe& operator+=(value_type arg) {
-    super_t::fetch_add(arg, std::memory_order_relaxed);
+    add(std::is_integral<value_type>{}, arg);
     return *this;
   }
   thread_safe& operator++() {
@@ -61,12 +174,155 @@ public:
     return *this;
   }
 
+  thread_safe& operator*=(value_type arg) {
+    detail::atomic_update(*this, [arg](value_type x) { return x * arg; });
+    return *this;
+  }
+
   template <class Archive>
   void serialize(Archive& ar, unsigned /* version */) {
     auto value = super_t::load();
     ar& make_nvp("value", value);
     super_t::store(value);
   }
+
+private:
+  void add(std::true_type, value_type arg) noexcept {
+    super_t::fetch_add(arg, std::memory_order_relaxed);
+  }
+
+  void add(std::false_type, value_type arg) noexcept {
+    detail::atomic_update(*this, [arg](value_type x) { return x + arg; });
+  }
+};
+
+/** Thread-safe adaptor for weighted_sum.
+
+  The sum of weights and the sum of weights squared are updated with separate atomic
+  operations, so filling is lock-free and no increment is lost. A reader which runs
+  concurrently with writers may see the two sums from different moments.
+*/
+template <class T>
+class thread_safe<weighted_sum<T>> {
+public:
+  using accumulator_type = weighted_sum<T>;
+  using value_type = T;
+
+  thread_safe() = default;
+  thread_safe(const thread_safe& o) noexcept : thread_safe(o.load()) {}
+  thread_safe& operator=(const thread_safe& o) noexcept {
+    store(o.load());
+    return *this;
+  }
+
+  thread_safe(const accumulator_type& x) noexcept
+      : sum_of_weights_(x.value()), sum_of_weights_squared_(x.variance()) {}
+
+  /// Return copy of the adapted accumulator.
+  accumulator_type load() const noexcept {
+    return {sum_of_weights_.load(), sum_of_weights_squared_.load()};
+  }
+
+  /// Replace the adapted accumulator.
+  void store(const accumulator_type& x) noexcept {
+    sum_of_weights_ = x.value();
+    sum_of_weights_squared_ = x.variance();
+  }
+
+  /// Increment by one.
+  thread_safe& operator++() {
+    ++sum_of_weights_;
+    ++sum_of_weights_squared_;
+    return *this;
+  }
+
+  /// Increment by weight.
+  template <class U>
+  thread_safe& operator+=(const weight_type<U>& w) {
+    sum_of_weights_ += static_cast<value_type>(w.value);
+    sum_of_weights_squared_ += static_cast<value_type>(w.value * w.value);
+    return *this;
+  }
+
+  /// Add another weighted sum.
+  thread_safe& operator+=(const accumulator_type& x) {
+    sum_of_weights_ += x.value();
+    sum_of_weights_squared_ += x.variance();
+    return *this;
+  }
+
+  thread_safe& operator+=(const thread_safe& o) { return operator+=(o.load()); }
+
+  /// Scale by value.
+  thread_safe& operator*=(const value_type& x) {
+    sum_of_weights_ *= x;
+    sum_of_weights_squared_ *= x * x;
+    return *this;
+  }
+
+  bool operator==(const thread_safe& o) const noexcept { return load() == o.load(); }
+  bool operator!=(const thread_safe& o) const noexcept { return !operator==(o); }
+
+  /// Return value of the sum.
+  value_type value() const noexcept { return sum_of_weights_.load(); }
+
+  /// Return estimated variance of the sum.
+  value_type variance() const noexcept { return sum_of_weights_squared_.load(); }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    auto value = load();
+    ar& make_nvp("value", value);
+    store(value);
+  }
+
+private:
+  thread_safe<value_type> sum_of_weights_;
+  thread_safe<value_type> sum_of_weights_squared_;
+};
+
+/** Thread-safe adaptor for mean.
+
+  Each update of the mean depends on the current state, so each accumulator is guarded
+  by a spin lock of its own. Threads only wait for each other when they update the same
+  accumulator.
+*/
+template <class T>
+class thread_safe<mean<T>>
+    : public detail::locked_accumulator<thread_safe<mean<T>>, mean<T>> {
+  using base_t = detail::locked_accumulator<thread_safe<mean<T>>, mean<T>>;
+
+public:
+  using base_t::base_t;
+  thread_safe() = default;
+
+  /// Return how many samples were accumulated.
+  T count() const noexcept { return this->load().count(); }
+};
+
+/** Thread-safe adaptor for weighted_mean.
+
+  Each update of the mean depends on the current state, so each accumulator is guarded
+  by a spin lock of its own. Threads only wait for each other when they update the same
+  accumulator.
+*/
+template <class T>
+class thread_safe<weighted_mean<T>>
+    : public detail::locked_accumulator<thread_safe<weighted_mean<T>>, weighted_mean<T>> {
+  using base_t =
+      detail::locked_accumulator<thread_safe<weighted_mean<T>>, weighted_mean<T>>;
+
+public:
+  using base_t::base_t;
+  thread_safe() = default;
+
+  /// Return sum of weights.
+  T sum_of_weights() const noexcept { return this->load().sum_of_weights(); }
+
+  /// Return sum of weights squared.
+  T sum_of_weights_squared() const noexcept {
+    return this->load().sum_of_weights_squared();
+  }
 };
 
 } // namespace accumulators
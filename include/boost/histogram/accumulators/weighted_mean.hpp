@@ -60,16 +60,28 @@ public:
     sum_of_weighted_deltas_squared_ += w.value * delta * (x - weighted_mean_);
   }
 
-  /// Add another weighted_mean
+  /** Add another weighted_mean
+
+   Uses the parallel algorithm of Chan et al., which adds the spread of the two means
+   to the sum of weighted squared deltas.
+  */
   weighted_mean& operator+=(const weighted_mean& rhs) {
-    if (sum_of_weights_ != 0 || rhs.sum_of_weights_ != 0) {
-      const auto tmp =
-          weighted_mean_ * sum_of_weights_ + rhs.weighted_mean_ * rhs.sum_of_weights_;
-      sum_of_weights_ += rhs.sum_of_weights_;
-      sum_of_weights_squared_ += rhs.sum_of_weights_squared_;
-      weighted_mean_ = tmp / sum_of_weights_;
+    // copy rhs first, it may be *this
+    const auto w2 = rhs.sum_of_weights_;
+    const auto w2sq = rhs.sum_of_weights_squared_;
+    const auto m2 = rhs.weighted_mean_;
+    const auto d2 = rhs.sum_of_weighted_deltas_squared_;
+    if (sum_of_weights_ != 0 || w2 != 0) {
+      const auto w1 = sum_of_weights_;
+      const auto m1 = weighted_mean_;
+      sum_of_weights_ += w2;
+      sum_of_weights_squared_ += w2sq;
+      weighted_mean_ = (m1 * w1 + m2 * w2) / sum_of_weights_;
+      sum_of_weighted_deltas_squared_ +=
+          w1 * (weighted_mean_ - m1) * (weighted_mean_ - m1) +
+          w2 * (weighted_mean_ - m2) * (weighted_mean_ - m2);
     }
-    sum_of_weighted_deltas_squared_ += rhs.sum_of_weighted_deltas_squared_;
+    sum_of_weighted_deltas_squared_ += d2;
     return *this;
   }
 
@@ -118,6 +130,8 @@ public:
   }
 
 private:
+  friend struct ::boost::histogram::unsafe_access;
+
   value_type sum_of_weights_{};
   value_type sum_of_weights_squared_{};
   value_type weighted_mean_{};
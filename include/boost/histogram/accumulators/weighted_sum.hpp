@@ -88,6 +88,8 @@ public:
   }
 
 private:
+  friend struct ::boost::histogram::unsafe_access;
+
   value_type sum_of_weights_{};
   value_type sum_of_weights_squared_{};
 };
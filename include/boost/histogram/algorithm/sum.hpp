@@ -10,11 +10,58 @@
 #include <boost/histogram/accumulators/sum.hpp>
 #include <boost/histogram/fwd.hpp>
 #include <boost/histogram/indexed.hpp>
+#include <boost/histogram/unsafe_access.hpp>
 #include <boost/mp11/utility.hpp>
+#include <cstddef>
 #include <type_traits>
 
 namespace boost {
 namespace histogram {
+namespace detail {
+
+template <class S, class Sum>
+void sum_all(const S& s, Sum& sum) {
+  for (auto&& x : s) sum += x;
+}
+
+// one typed loop over the buffer instead of a dispatch on the cell type for each cell
+template <class A, class Sum>
+void sum_all(const unlimited_storage<A>& s, Sum& sum) {
+  s.visit([&sum](const auto* p, std::size_t n) {
+    for (auto end = p + n; p != end; ++p) sum += static_cast<double>(*p);
+  });
+}
+
+template <class A, std::size_t N, class Sum>
+void sum_all(const blocked_unlimited_storage<A, N>& s, Sum& sum) {
+  for (std::size_t i = 0; i < s.blocks(); ++i) sum_all(s.block(i), sum);
+}
+
+// cells which are not in the table are zero
+template <class T, class A, class Sum>
+void sum_all(const sparse_storage<T, A>& s, Sum& sum) {
+  for (auto&& c : s.filled()) sum += c.value;
+}
+
+// cells in pages which are not allocated are zero
+template <class T, std::size_t N, class A, class Sum>
+void sum_all(const paged_storage<T, N, A>& s, Sum& sum) {
+  for (std::size_t i = 0; i < s.pages(); ++i)
+    if (auto p = s.page(i))
+      for (auto end = p + N; p != end; ++p) sum += *p;
+}
+
+// the sums of weights and the sums of weights squared are contiguous arrays
+template <class T, class A, class Sum>
+void sum_all(const soa_storage<accumulators::weighted_sum<T>, A>& s, Sum& sum) {
+  T value = 0, variance = 0;
+  for (auto p = s.field(0), end = p + s.size(); p != end; ++p) value += *p;
+  for (auto p = s.field(1), end = p + s.size(); p != end; ++p) variance += *p;
+  sum += accumulators::weighted_sum<T>(value, variance);
+}
+
+} // namespace detail
+
 namespace algorithm {
 
 /** Compute the sum over all histogram cells (underflow/overflow included by default).
@@ -52,7 +99,7 @@ auto sum(const histogram<A, S>& hist, const coverage cov = coverage::all) {
   using sum_type = mp11::mp_if<std::is_arithmetic<T>, accumulators::sum<double>, T>;
   sum_type sum;
   if (cov == coverage::all)
-    for (auto&& x : hist) sum += x;
+    detail::sum_all(unsafe_access::storage(hist), sum);
   else
     // sum += x also works if sum_type::operator+=(const sum_type&) exists
     for (auto&& x : indexed(hist)) sum += *x;
@@ -12,6 +12,7 @@
 #include <boost/histogram/axis/iterator.hpp>
 #include <boost/histogram/axis/metadata_base.hpp>
 #include <boost/histogram/axis/option.hpp>
+#include <boost/histogram/detail/hash_index.hpp>
 #include <boost/histogram/fwd.hpp>
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
@@ -31,6 +32,9 @@ namespace axis {
   constructor. The optional overflow bin for this axis counts input values that
   are not part of the set. Binning has O(N) complexity, but with a very small
   factor. For small N (the typical use case) it beats other kinds of lookup.
+  For large N, enable the `hashed` option to get O(1) binning from a hash table of
+  the values, which then must be hashable with `std::hash`. The option does not
+  change the bin order or the serialized representation.
 
   @tparam Value input value type, must be equal-comparable.
   @tparam MetaData type to store meta data.
@@ -49,6 +53,9 @@ class category : public iterator_mixin<category<Value, MetaData, Options, Alloca
   using options_type = detail::replace_default<Options, option::overflow_t>;
   using allocator_type = Allocator;
   using vector_type = std::vector<value_type, allocator_type>;
+  using index_lookup_type =
+      std::conditional_t<options_type::test(option::hashed),
+                         detail::hash_index<allocator_type>, detail::linear_index>;
 
   static_assert(!options_type::test(option::underflow),
                 "category axis cannot have underflow");
@@ -60,7 +67,7 @@ class category : public iterator_mixin<category<Value, MetaData, Options, Alloca
 
 public:
   constexpr category() = default;
-  explicit category(allocator_type alloc) : vec_(alloc) {}
+  explicit category(allocator_type alloc) : vec_(alloc), lookup_(alloc) {}
 
   /** Construct from iterator range of unique values.
    *
@@ -71,12 +78,13 @@ public:
    */
   template <class It, class = detail::requires_iterator<It>>
   category(It begin, It end, metadata_type meta = {}, allocator_type alloc = {})
-      : metadata_base<MetaData>(std::move(meta)), vec_(alloc) {
+      : metadata_base<MetaData>(std::move(meta)), vec_(alloc), lookup_(alloc) {
     if (std::distance(begin, end) < 0)
       BOOST_THROW_EXCEPTION(
           std::invalid_argument("end must be reachable by incrementing begin"));
     vec_.reserve(std::distance(begin, end));
     while (begin != end) vec_.emplace_back(*begin++);
+    lookup_.build(vec_);
   }
 
   /** Construct axis from iterable sequence of unique values.
@@ -113,17 +121,14 @@ public:
   }
 
   /// Return index for value argument.
-  index_type index(const value_type& x) const noexcept {
-    const auto beg = vec_.begin();
-    const auto end = vec_.end();
-    return static_cast<index_type>(std::distance(beg, std::find(beg, end, x)));
-  }
+  index_type index(const value_type& x) const noexcept { return lookup_.find(vec_, x); }
 
   /// Returns index and shift (if axis has grown) for the passed argument.
   std::pair<index_type, index_type> update(const value_type& x) {
     const auto i = index(x);
     if (i < size()) return {i, 0};
     vec_.emplace_back(x);
+    lookup_.push_back(vec_);
     return {i, -1};
   }
 
@@ -173,10 +178,12 @@ public:
   void serialize(Archive& ar, unsigned /* version */) {
     ar& make_nvp("seq", vec_);
     ar& make_nvp("meta", this->metadata());
+    if (Archive::is_loading::value) lookup_.build(vec_);
   }
 
 private:
   vector_type vec_;
+  index_lookup_type lookup_;
 
   template <class V, class M, class O, class A>
   friend class category;
@@ -72,6 +72,9 @@ constexpr circular_t circular{}; ///< Instance of `circular_t`.
 /// Axis can grow. Mutually exclusive with `circular`.
 using growth_t = bit<3>;
 constexpr growth_t growth{}; ///< Instance of `growth_t`.
+/// Axis uses a hash table for value lookup. Only used by the category axis.
+using hashed_t = bit<4>;
+constexpr hashed_t hashed{}; ///< Instance of `hashed_t`.
 
 } // namespace option
 } // namespace axis
@@ -74,6 +74,7 @@ void stream_options(OStream& os, const unsigned bits) {
   BOOST_HISTOGRAM_AXIS_OPTION_OSTREAM(overflow);
   BOOST_HISTOGRAM_AXIS_OPTION_OSTREAM(circular);
   BOOST_HISTOGRAM_AXIS_OPTION_OSTREAM(growth);
+  BOOST_HISTOGRAM_AXIS_OPTION_OSTREAM(hashed);
 
 #undef BOOST_HISTOGRAM_AXIS_OPTION_OSTREAM
 
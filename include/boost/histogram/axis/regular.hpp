@@ -20,12 +20,17 @@
 #include <boost/mp11/utility.hpp>
 #include <boost/throw_exception.hpp>
 #include <cmath>
+#include <cstddef>
 #include <limits>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <utility>
 
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
 namespace boost {
 namespace histogram {
 namespace detail {
@@ -59,6 +64,66 @@ R get_scale(const T& t) {
   return t / get_unit_type<T>();
 }
 
+// Batch version of regular::index for the identity transform and a non-circular axis.
+// Computes the same floating point operations as the scalar version in the same order
+// and returns identical indices. The branches are replaced by selects, so that the
+// scalar loop is vectorizable and the explicit SIMD versions are exact.
+template <class T>
+void index_n_regular(const T* x, std::size_t n, const T min, const T delta,
+                     const axis::index_type size, axis::index_type* out) noexcept {
+  for (; n > 0; --n) {
+    const auto z = (*x++ - min) / delta;
+    *out++ = z < 1 ? (z >= 0 ? static_cast<axis::index_type>(z * size) : -1) : size;
+  }
+}
+
+#if defined(__AVX512F__) || defined(__AVX__)
+inline void index_n_regular(const double* x, std::size_t n, const double min,
+                            const double delta, const axis::index_type size,
+                            axis::index_type* out) noexcept {
+#if defined(__AVX512F__)
+  {
+    const auto vmin = _mm512_set1_pd(min);
+    const auto vdelta = _mm512_set1_pd(delta);
+    const auto vsize = _mm512_set1_pd(size);
+    const auto vone = _mm512_set1_pd(1);
+    const auto vzero = _mm512_setzero_pd();
+    const auto vminus_one = _mm512_set1_pd(-1);
+    for (; n >= 8; n -= 8, x += 8, out += 8) {
+      const auto z = _mm512_div_pd(_mm512_sub_pd(_mm512_loadu_pd(x), vmin), vdelta);
+      const auto in_range = _mm512_cmp_pd_mask(z, vone, _CMP_LT_OQ) &
+                            _mm512_cmp_pd_mask(z, vzero, _CMP_GE_OQ);
+      // NaN and z >= 1 yield size
+      auto r = _mm512_mask_blend_pd(in_range, vsize, _mm512_mul_pd(z, vsize));
+      r = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(z, vzero, _CMP_LT_OQ), r, vminus_one);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_cvttpd_epi32(r));
+    }
+  }
+#endif
+#if defined(__AVX__)
+  {
+    const auto vmin = _mm256_set1_pd(min);
+    const auto vdelta = _mm256_set1_pd(delta);
+    const auto vsize = _mm256_set1_pd(size);
+    const auto vone = _mm256_set1_pd(1);
+    const auto vzero = _mm256_setzero_pd();
+    const auto vminus_one = _mm256_set1_pd(-1);
+    for (; n >= 4; n -= 4, x += 4, out += 4) {
+      const auto z = _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(x), vmin), vdelta);
+      const auto in_range = _mm256_and_pd(_mm256_cmp_pd(z, vone, _CMP_LT_OQ),
+                                          _mm256_cmp_pd(z, vzero, _CMP_GE_OQ));
+      // NaN and z >= 1 yield size
+      auto r = _mm256_blendv_pd(vsize, _mm256_mul_pd(z, vsize), in_range);
+      r = _mm256_blendv_pd(r, vminus_one, _mm256_cmp_pd(z, vzero, _CMP_LT_OQ));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_cvttpd_epi32(r));
+    }
+  }
+#endif
+  // remainder
+  index_n_regular<double>(x, n, min, delta, size, out);
+}
+#endif
+
 } // namespace detail
 
 namespace axis {
@@ -307,6 +372,23 @@ public:
     return size(); // also returned if x is NaN
   }
 
+  /** Compute indices for a contiguous sequence of values.
+
+    Implementation detail, used by histogram::fill. The result is identical to calling
+    index() for each value, but faster for the identity transform.
+
+    @param x pointer to first value.
+    @param n number of values.
+    @param out pointer to first element of output buffer with n elements.
+  */
+  void index_n(const value_type* x, std::size_t n, index_type* out) const noexcept {
+    index_n_impl(
+        mp11::mp_bool<(std::is_same<transform_type, transform::id>::value &&
+                       std::is_same<value_type, internal_value_type>::value &&
+                       !options_type::test(option::circular))>{},
+        x, n, out);
+  }
+
   /// Returns index and shift (if axis has grown) for the passed argument.
   std::pair<index_type, index_type> update(value_type x) noexcept {
     BOOST_ASSERT(options_type::test(option::growth));
@@ -384,6 +466,16 @@ public:
   }
 
 private:
+  void index_n_impl(std::true_type, const value_type* x, std::size_t n,
+                    index_type* out) const noexcept {
+    detail::index_n_regular(x, n, min_, delta_, size(), out);
+  }
+
+  void index_n_impl(std::false_type, const value_type* x, std::size_t n,
+                    index_type* out) const noexcept {
+    for (; n > 0; --n) *out++ = index(*x++);
+  }
+
   index_type size_{0};
   internal_value_type min_{0}, delta_{1};
 
@@ -16,11 +16,13 @@
 #include <boost/histogram/axis/option.hpp>
 #include <boost/histogram/detail/convert_integer.hpp>
 #include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/eytzinger_search.hpp>
 #include <boost/histogram/detail/limits.hpp>
 #include <boost/histogram/detail/replace_type.hpp>
 #include <boost/histogram/fwd.hpp>
 #include <boost/throw_exception.hpp>
 #include <cmath>
+#include <cstddef>
 #include <limits>
 #include <memory>
 #include <stdexcept>
@@ -36,8 +38,10 @@ namespace axis {
 /**
   Axis for non-equidistant bins on the real line.
 
-  Binning is a O(log(N)) operation. If speed matters and the problem domain
-  allows it, prefer a regular axis, possibly with a transform.
+  Binning is a O(log(N)) operation. The search runs over a copy of the bin edges in
+  Eytzinger layout, which is more cache-friendly than a binary search over the sorted
+  edges. If speed matters and the problem domain allows it, prefer a regular axis,
+  possibly with a transform.
 
   @tparam Value input value type, must be floating point.
   @tparam MetaData type to store meta data.
@@ -67,7 +71,7 @@ class variable : public iterator_mixin<variable<Value, MetaData, Options, Alloca
 
 public:
   constexpr variable() = default;
-  explicit variable(allocator_type alloc) : vec_(alloc) {}
+  explicit variable(allocator_type alloc) : vec_(alloc), search_(alloc) {}
 
   /** Construct from iterator range of bin edges.
    *
@@ -78,7 +82,7 @@ public:
    */
   template <class It, class = detail::requires_iterator<It>>
   variable(It begin, It end, metadata_type meta = {}, allocator_type alloc = {})
-      : metadata_base<MetaData>(std::move(meta)), vec_(std::move(alloc)) {
+      : metadata_base<MetaData>(std::move(meta)), vec_(alloc), search_(alloc) {
     if (std::distance(begin, end) < 2)
       BOOST_THROW_EXCEPTION(std::invalid_argument("bins > 0 required"));
 
@@ -92,6 +96,7 @@ public:
     if (!strictly_ascending)
       BOOST_THROW_EXCEPTION(
           std::invalid_argument("input sequence must be strictly ascending"));
+    search_.build(vec_);
   }
 
   /** Construct variable axis from iterable range of bin edges.
@@ -118,24 +123,42 @@ public:
 
   /// Constructor used by algorithm::reduce to shrink and rebin (not for users).
   variable(const variable& src, index_type begin, index_type end, unsigned merge)
-      : metadata_base<MetaData>(src), vec_(src.get_allocator()) {
+      : metadata_base<MetaData>(src)
+      , vec_(src.get_allocator())
+      , search_(src.get_allocator()) {
     BOOST_ASSERT((end - begin) % merge == 0);
     if (options_type::test(option::circular) && !(begin == 0 && end == src.size()))
       BOOST_THROW_EXCEPTION(std::invalid_argument("cannot shrink circular axis"));
     vec_.reserve((end - begin) / merge);
     const auto beg = src.vec_.begin();
     for (index_type i = begin; i <= end; i += merge) vec_.emplace_back(*(beg + i));
+    search_.build(vec_);
   }
 
   /// Return index for value argument.
   index_type index(value_type x) const noexcept {
-    if (options_type::test(option::circular)) {
-      const auto a = vec_[0];
-      const auto b = vec_[size()];
-      x -= std::floor((x - a) / (b - a)) * (b - a);
+    return search_.upper_bound(wrap(x)) - 1;
+  }
+
+  /** Compute indices for a contiguous sequence of values.
+
+    Implementation detail, used by histogram::fill. The result is identical to calling
+    index() for each value, but several searches run interleaved to hide the latency
+    of the memory accesses.
+
+    @param x pointer to first value.
+    @param n number of values.
+    @param out pointer to first element of output buffer with n elements.
+  */
+  void index_n(const value_type* x, std::size_t n, index_type* out) const noexcept {
+    constexpr std::size_t block = 8;
+    value_type buffer[block];
+    for (; n >= block; n -= block, x += block, out += block) {
+      for (std::size_t i = 0; i < block; ++i) buffer[i] = wrap(x[i]);
+      search_.template upper_bound_n<block>(buffer, out);
+      for (std::size_t i = 0; i < block; ++i) --out[i];
     }
-    return static_cast<index_type>(std::upper_bound(vec_.begin(), vec_.end(), x) -
-                                   vec_.begin() - 1);
+    for (std::size_t i = 0; i < n; ++i) out[i] = index(x[i]);
   }
 
   std::pair<index_type, index_type> update(value_type x) noexcept {
@@ -147,11 +170,13 @@ public:
         x = std::nextafter(x, (std::numeric_limits<value_type>::max)());
         x = (std::max)(x, vec_.back() + d);
         vec_.push_back(x);
+        search_.build(vec_);
         return {i, -1};
       }
       const auto d = value(0.5) - value(0);
       x = (std::min)(x, value(0) - d);
       vec_.insert(vec_.begin(), x);
+      search_.build(vec_);
       return {0, -i};
     }
     return {x < 0 ? -1 : size(), 0};
@@ -205,10 +230,21 @@ public:
   void serialize(Archive& ar, unsigned /* version */) {
     ar& make_nvp("seq", vec_);
     ar& make_nvp("meta", this->metadata());
+    if (Archive::is_loading::value) search_.build(vec_);
   }
 
 private:
+  value_type wrap(value_type x) const noexcept {
+    if (options_type::test(option::circular)) {
+      const auto a = vec_[0];
+      const auto b = vec_[size()];
+      x -= std::floor((x - a) / (b - a)) * (b - a);
+    }
+    return x;
+  }
+
   vector_type vec_;
+  detail::eytzinger_search<value_type, allocator_type> search_;
 
   template <class V, class M, class O, class A>
   friend class variable;
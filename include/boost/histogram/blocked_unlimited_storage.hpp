@@ -0,0 +1,194 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_BLOCKED_UNLIMITED_STORAGE_HPP
+#define BOOST_HISTOGRAM_BLOCKED_UNLIMITED_STORAGE_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <boost/histogram/unlimited_storage.hpp>
+#include <boost/mp11/utility.hpp>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Memory-efficient storage for integral counters which cannot overflow, with a counter
+  width that is chosen separately for each block of cells.
+
+  This storage behaves like unlimited_storage, but splits the cells into blocks of fixed
+  size. Each block is an unlimited_storage, so a counter which is about to overflow only
+  widens the counters in its own block. A histogram with a few very large counts and
+  many small counts thus stays close to one byte per cell.
+
+  Accessing a cell requires an additional lookup of its block, which makes this storage
+  a bit slower than unlimited_storage for small histograms.
+
+  @tparam Allocator allocator for the blocks.
+  @tparam BlockSize number of cells per block, must be a power of two.
+*/
+template <class Allocator, std::size_t BlockSize>
+class blocked_unlimited_storage {
+  static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0,
+                "BlockSize must be a power of two");
+
+public:
+  static constexpr bool has_threading_support = false;
+  static constexpr std::size_t block_size = BlockSize;
+
+  using allocator_type = Allocator;
+  using block_type = unlimited_storage<allocator_type>;
+  using value_type = typename block_type::value_type;
+  using large_int = typename block_type::large_int;
+  using reference = typename block_type::reference;
+  using const_reference = typename block_type::const_reference;
+
+private:
+  using block_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<block_type>;
+  using blocks_type = std::vector<block_type, block_allocator_type>;
+
+  template <class Value, class Reference, class Blocks>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, Blocks>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class B>
+    iterator_impl(const iterator_impl<V, R, B>& it)
+        : iterator_impl::iterator_adaptor_(it.base()), blocks_(it.blocks_) {}
+    iterator_impl(Blocks* b, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), blocks_(b) {}
+
+    Reference operator*() const noexcept {
+      const auto i = this->base();
+      return (*blocks_)[i / BlockSize][i % BlockSize];
+    }
+
+    template <class V, class R, class B>
+    friend class iterator_impl;
+
+  private:
+    Blocks* blocks_ = nullptr;
+  };
+
+public:
+  using const_iterator =
+      iterator_impl<const value_type, const_reference, const blocks_type>;
+  using iterator = iterator_impl<value_type, reference, blocks_type>;
+
+  explicit blocked_unlimited_storage(const allocator_type& a = {})
+      : blocks_(block_allocator_type(a)) {}
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit blocked_unlimited_storage(const Iterable& s) {
+    using std::begin;
+    using std::end;
+    auto s_begin = begin(s);
+    auto s_end = end(s);
+    using V = typename std::iterator_traits<decltype(s_begin)>::value_type;
+    // other values are converted to double, like in unlimited_storage
+    using W = mp11::mp_if_c<(std::is_arithmetic<V>::value ||
+                             std::is_same<V, large_int>::value),
+                            V, double>;
+    reset(static_cast<std::size_t>(std::distance(s_begin, s_end)));
+    for (auto&& x : *this) x = static_cast<W>(*s_begin++);
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  blocked_unlimited_storage& operator=(const Iterable& s) {
+    *this = blocked_unlimited_storage(s);
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(blocks_.get_allocator()); }
+
+  void reset(std::size_t n) {
+    const auto alloc = get_allocator();
+    blocks_type blocks(block_allocator_type{alloc});
+    blocks.reserve((n + BlockSize - 1) / BlockSize);
+    for (std::size_t i = 0; i < n; i += BlockSize) {
+      blocks.emplace_back(alloc);
+      blocks.back().reset((std::min)(BlockSize, n - i));
+    }
+    blocks_ = std::move(blocks);
+    size_ = n;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  reference operator[](std::size_t i) noexcept {
+    BOOST_ASSERT(i < size_);
+    return blocks_[i / BlockSize][i % BlockSize];
+  }
+
+  const_reference operator[](std::size_t i) const noexcept {
+    BOOST_ASSERT(i < size_);
+    return blocks_[i / BlockSize][i % BlockSize];
+  }
+
+  bool operator==(const blocked_unlimited_storage& x) const noexcept {
+    // same size implies same partition into blocks
+    return size_ == x.size_ &&
+           std::equal(blocks_.begin(), blocks_.end(), x.blocks_.begin());
+  }
+
+  template <class Iterable>
+  bool operator==(const Iterable& iterable) const {
+    if (size() != iterable.size()) return false;
+    return std::equal(begin(), end(), std::begin(iterable),
+                      [](const_reference a, const auto& b) { return a == b; });
+  }
+
+  blocked_unlimited_storage& operator*=(const double x) {
+    for (auto&& b : blocks_) b *= x;
+    return *this;
+  }
+
+  /// Add cells of another storage of same size, block by block.
+  blocked_unlimited_storage& operator+=(const blocked_unlimited_storage& x) {
+    BOOST_ASSERT(size() == x.size());
+    for (std::size_t i = 0; i < blocks_.size(); ++i) blocks_[i] += x.blocks_[i];
+    return *this;
+  }
+
+  iterator begin() noexcept { return {&blocks_, 0}; }
+  iterator end() noexcept { return {&blocks_, size_}; }
+  const_iterator begin() const noexcept { return {&blocks_, 0}; }
+  const_iterator end() const noexcept { return {&blocks_, size_}; }
+
+  /// Number of blocks.
+  std::size_t blocks() const noexcept { return blocks_.size(); }
+
+  /// Access block with index i.
+  const block_type& block(std::size_t i) const noexcept {
+    BOOST_ASSERT(i < blocks_.size());
+    return blocks_[i];
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    ar& make_nvp("size", size_);
+    ar& make_nvp("blocks", blocks_);
+  }
+
+private:
+  blocks_type blocks_;
+  std::size_t size_ = 0;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
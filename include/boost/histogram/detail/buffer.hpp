@@ -0,0 +1,88 @@
+// Copyright 2015-2019 Hans Dembinski
+// Copyright 2019 Glen Joseph Fernandes (glenjofe@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_DETAIL_BUFFER_HPP
+#define BOOST_HISTOGRAM_DETAIL_BUFFER_HPP
+
+#include <boost/assert.hpp>
+#include <boost/core/alloc_construct.hpp>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+template <class Allocator>
+class construct_guard {
+public:
+  using pointer = typename std::allocator_traits<Allocator>::pointer;
+
+  construct_guard(Allocator& a, pointer p, std::size_t n) noexcept
+      : a_(a), p_(p), n_(n) {}
+
+  ~construct_guard() {
+    if (p_) { a_.deallocate(p_, n_); }
+  }
+
+  void release() { p_ = pointer(); }
+
+  construct_guard(const construct_guard&) = delete;
+  construct_guard& operator=(const construct_guard&) = delete;
+
+private:
+  Allocator& a_;
+  pointer p_;
+  std::size_t n_;
+};
+
+template <class Allocator>
+void* buffer_create(Allocator& a, std::size_t n) {
+  auto ptr = a.allocate(n); // may throw
+  static_assert(std::is_trivially_copyable<decltype(ptr)>::value,
+                "ptr must be trivially copyable");
+  construct_guard<Allocator> guard(a, ptr, n);
+  boost::alloc_construct_n(a, ptr, n);
+  guard.release();
+  return static_cast<void*>(ptr);
+}
+
+template <class Allocator, class Iterator>
+auto buffer_create(Allocator& a, std::size_t n, Iterator iter) {
+  BOOST_ASSERT(n > 0u);
+  auto ptr = a.allocate(n); // may throw
+  static_assert(std::is_trivially_copyable<decltype(ptr)>::value,
+                "ptr must be trivially copyable");
+  construct_guard<Allocator> guard(a, ptr, n);
+  using T = typename std::allocator_traits<Allocator>::value_type;
+  struct casting_iterator {
+    void operator++() noexcept { ++iter_; }
+    T operator*() noexcept {
+      return static_cast<T>(*iter_);
+    } // silence conversion warnings
+    Iterator iter_;
+  };
+  boost::alloc_construct_n(a, ptr, n, casting_iterator{iter});
+  guard.release();
+  return ptr;
+}
+
+template <class Allocator>
+void buffer_destroy(Allocator& a, typename std::allocator_traits<Allocator>::pointer p,
+                    std::size_t n) {
+  BOOST_ASSERT(p);
+  BOOST_ASSERT(n > 0u);
+  boost::alloc_destroy_n(a, p, n);
+  a.deallocate(p, n);
+}
+
+} // namespace detail
+} // namespace histogram
+} // namespace boost
+
+#endif
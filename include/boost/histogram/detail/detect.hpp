@@ -48,6 +48,8 @@ BOOST_HISTOGRAM_DETAIL_DETECT(has_method_value, &T::value);
 
 BOOST_HISTOGRAM_DETAIL_DETECT(has_method_update, &T::update);
 
+BOOST_HISTOGRAM_DETAIL_DETECT(has_method_index_n, &T::index_n);
+
 // reset has overloads, trying to get pmf in this case always fails
 BOOST_HISTOGRAM_DETAIL_DETECT(has_method_reset, (std::declval<T>().reset(0)));
 
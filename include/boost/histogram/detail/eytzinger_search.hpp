@@ -0,0 +1,112 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_DETAIL_EYTZINGER_SEARCH_HPP
+#define BOOST_HISTOGRAM_DETAIL_EYTZINGER_SEARCH_HPP
+
+#include <boost/assert.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+// removes trailing ones and the following zero, which returns the node where the
+// search went left for the last time; this is the smallest value larger than x
+inline std::size_t eytzinger_unwind(std::size_t k) noexcept {
+#if defined(__GNUC__)
+  return k >> (__builtin_ctzll(~static_cast<unsigned long long>(k)) + 1);
+#else
+  while (k & 1) k >>= 1;
+  return k >> 1;
+#endif
+}
+
+/*
+  Copy of a sorted sequence in Eytzinger layout (the implicit binary tree of a heap),
+  which gives the same results as std::upper_bound on the original sequence.
+
+  The first levels of the tree are used in every search and stay hot in the cache, the
+  loop has no unpredictable branches, and several searches can run interleaved to hide
+  memory latency.
+*/
+template <class T, class Allocator>
+class eytzinger_search {
+  using index_allocator_type = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<axis::index_type>;
+
+public:
+  explicit eytzinger_search(const Allocator& a = {}) : tree_(a), rank_(a) {}
+
+  template <class Vector>
+  void build(const Vector& sorted) {
+    const auto n = sorted.size();
+    tree_.resize(n + 1);
+    rank_.resize(n + 1);
+    size_ = static_cast<axis::index_type>(n);
+    std::size_t i = 0;
+    fill(sorted, i, 1);
+    BOOST_ASSERT(i == n);
+    // number of completely filled levels of the tree
+    levels_ = 0;
+    while ((std::size_t{2} << levels_) - 1 <= n) ++levels_;
+  }
+
+  // returns std::upper_bound(sorted.begin(), sorted.end(), x) - sorted.begin()
+  axis::index_type upper_bound(const T& x) const noexcept {
+    std::size_t k = 1;
+    for (unsigned l = 0; l < levels_; ++l) k = descend(k, x);
+    if (k < tree_.size()) k = descend(k, x);
+    return rank(eytzinger_unwind(k));
+  }
+
+  // same as upper_bound(x[i]) for i = 0 .. N-1, interleaves N searches
+  template <std::size_t N>
+  void upper_bound_n(const T* x, axis::index_type* out) const noexcept {
+    std::size_t k[N];
+    for (auto&& ki : k) ki = 1;
+    for (unsigned l = 0; l < levels_; ++l)
+      for (std::size_t i = 0; i < N; ++i) k[i] = descend(k[i], x[i]);
+    for (std::size_t i = 0; i < N; ++i) {
+      if (k[i] < tree_.size()) k[i] = descend(k[i], x[i]);
+      out[i] = rank(eytzinger_unwind(k[i]));
+    }
+  }
+
+private:
+  // node zero means that no element is larger than the searched value
+  axis::index_type rank(const std::size_t k) const noexcept {
+    return k ? rank_[k] : size_;
+  }
+
+  std::size_t descend(const std::size_t k, const T& x) const noexcept {
+    // same comparison as std::upper_bound, so that NaN is handled identically
+    return 2 * k + !(x < tree_[k]);
+  }
+
+  template <class Vector>
+  void fill(const Vector& sorted, std::size_t& i, const std::size_t k) {
+    if (k >= tree_.size()) return;
+    fill(sorted, i, 2 * k);
+    tree_[k] = sorted[i];
+    rank_[k] = static_cast<axis::index_type>(i++);
+    fill(sorted, i, 2 * k + 1);
+  }
+
+  std::vector<T, Allocator> tree_;
+  std::vector<axis::index_type, index_allocator_type> rank_;
+  axis::index_type size_ = 0;
+  unsigned levels_ = 0;
+};
+
+} // namespace detail
+} // namespace histogram
+} // namespace boost
+
+#endif
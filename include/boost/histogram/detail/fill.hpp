@@ -17,6 +17,7 @@
 #include <boost/histogram/detail/axes.hpp>
 #include <boost/histogram/detail/linearize.hpp>
 #include <boost/histogram/detail/make_default.hpp>
+#include <boost/histogram/detail/mutex_base.hpp>
 #include <boost/histogram/detail/optional_index.hpp>
 #include <boost/histogram/detail/priority.hpp>
 #include <boost/histogram/detail/tuple_slice.hpp>
@@ -26,6 +27,7 @@
 #include <boost/mp11/tuple.hpp>
 #include <boost/mp11/utility.hpp>
 #include <mutex>
+#include <shared_mutex>
 #include <tuple>
 #include <type_traits>
 
@@ -271,6 +273,36 @@ auto fill_2(ArgTraits, mp11::mp_true, const std::size_t, Storage& st, Axes& axes
                       args);
 }
 
+template <class ArgTraits, class Growing, class Storage, class Axes, class Args,
+          class Mutex>
+auto fill_locked(ArgTraits, Growing, const std::size_t offset, Storage& st, Axes& axes,
+                 const Args& args, Mutex& m) {
+  std::lock_guard<Mutex> guard{m};
+  return fill_2(ArgTraits{}, Growing{}, offset, st, axes, args);
+}
+
+// thread-safe storage and at least one growing axis
+template <class ArgTraits, class Storage, class Axes, class Args>
+auto fill_locked(ArgTraits, mp11::mp_true, const std::size_t offset, Storage& st,
+                 Axes& axes, const Args& args, growth_mutex& m) {
+  {
+    // most fills do not grow an axis, these run concurrently under a shared lock
+    std::shared_lock<growth_mutex> guard{m};
+    mp11::mp_if<has_non_inclusive_axis<Axes>, optional_index, std::size_t> idx{0};
+    std::size_t stride = 1;
+    mp11::mp_for_each<mp11::mp_iota_c<min<Axes>(ArgTraits::nargs::value)>>([&](auto i) {
+      if (stride == 0) return;
+      stride *= linearize_no_growth(idx, stride, axis_get<i>(axes),
+                                    std::get<(ArgTraits::start::value + i)>(args));
+    });
+    if (stride > 0)
+      return fill_storage(typename ArgTraits::wpos{}, typename ArgTraits::spos{}, st,
+                          idx, args);
+  }
+  std::lock_guard<growth_mutex> guard{m};
+  return fill_2(ArgTraits{}, mp11::mp_true{}, offset, st, axes, args);
+}
+
 // pack original args tuple into another tuple (which is unpacked later)
 template <int Start, int Size, class IW, class IS, class Args>
 decltype(auto) pack_args(IW, IS, const Args& args) noexcept {
@@ -297,9 +329,9 @@ decltype(auto) pack_args(mp11::mp_int<-1>, mp11::mp_int<-1>, const Args& args) n
 #pragma warning(disable : 4702) // fixing warning would reduce code readability a lot
 #endif
 
-template <class ArgTraits, class S, class A, class Args>
+template <class ArgTraits, class S, class A, class Args, class Mutex>
 auto fill(std::true_type, ArgTraits, const std::size_t offset, S& storage, A& axes,
-          const Args& args) -> typename S::iterator {
+          const Args& args, Mutex& m) -> typename S::iterator {
   using growing = has_growing_axis<A>;
 
   // Sometimes we need to pack the tuple into another tuple:
@@ -315,17 +347,18 @@ auto fill(std::true_type, ArgTraits, const std::size_t offset, S& storage, A& ax
   //   3d tuple)
 
   if (axes_rank(axes) == ArgTraits::nargs::value)
-    return fill_2(ArgTraits{}, growing{}, offset, storage, axes, args);
+    return fill_locked(ArgTraits{}, growing{}, offset, storage, axes, args, m);
   else if (axes_rank(axes) == 1 &&
            axis::traits::rank(axis_get<0>(axes)) == ArgTraits::nargs::value)
-    return fill_2(
+    return fill_locked(
         argument_traits_holder<
             1, 0, (ArgTraits::wpos::value >= 0 ? 1 : -1),
             (ArgTraits::spos::value >= 0 ? (ArgTraits::wpos::value >= 0 ? 2 : 1) : -1),
             typename ArgTraits::sargs>{},
         growing{}, offset, storage, axes,
         pack_args<ArgTraits::start::value, ArgTraits::nargs::value>(
-            typename ArgTraits::wpos{}, typename ArgTraits::spos{}, args));
+            typename ArgTraits::wpos{}, typename ArgTraits::spos{}, args),
+        m);
   return (BOOST_THROW_EXCEPTION(
               std::invalid_argument("number of arguments != histogram rank")),
           storage.end());
@@ -336,9 +369,9 @@ auto fill(std::true_type, ArgTraits, const std::size_t offset, S& storage, A& ax
 #endif
 
 // empty implementation for bad arguments to stop compiler from showing internals
-template <class ArgTraits, class S, class A, class Args>
-auto fill(std::false_type, ArgTraits, const std::size_t, S& storage, A&, const Args&) ->
-    typename S::iterator {
+template <class ArgTraits, class S, class A, class Args, class Mutex>
+auto fill(std::false_type, ArgTraits, const std::size_t, S& storage, A&, const Args&,
+          Mutex&) -> typename S::iterator {
   return storage.end();
 }
 
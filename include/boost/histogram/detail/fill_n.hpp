@@ -9,6 +9,9 @@
 
 #include <algorithm>
 #include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/core/ignore_unused.hpp>
+#include <boost/core/no_exceptions_support.hpp>
 #include <boost/histogram/axis/option.hpp>
 #include <boost/histogram/axis/traits.hpp>
 #include <boost/histogram/detail/axes.hpp>
@@ -19,15 +22,29 @@
 #include <boost/histogram/detail/optional_index.hpp>
 #include <boost/histogram/detail/span.hpp>
 #include <boost/histogram/detail/static_if.hpp>
+#include <boost/histogram/fill_tuning.hpp>
 #include <boost/histogram/fwd.hpp>
+#include <boost/histogram/selection.hpp>
+#include <boost/histogram/strided.hpp>
+#include <boost/histogram/threads.hpp>
+#include <boost/histogram/weight.hpp>
 #include <boost/mp11/algorithm.hpp>
 #include <boost/mp11/bind.hpp>
+#include <boost/mp11/function.hpp>
 #include <boost/mp11/utility.hpp>
 #include <boost/throw_exception.hpp>
 #include <boost/variant2/variant.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace boost {
 namespace histogram {
@@ -59,7 +76,35 @@ decltype(auto) maybe_visit(F&& f, V&& v) {
       std::forward<F>(f), std::forward<V>(v));
 }
 
-template <class Index, class Axis, class IsGrowing>
+// iterates over the values in the selected rows
+template <class Iterator, class Row>
+struct row_iterator {
+  Iterator base;
+  const Row* row;
+
+  decltype(auto) operator*() const { return base[static_cast<std::size_t>(*row)]; }
+
+  row_iterator operator++(int) noexcept {
+    auto tmp = *this;
+    ++row;
+    return tmp;
+  }
+};
+
+// values start at row number start...
+template <class Iterator>
+Iterator select_values(Iterator it, const std::size_t start) noexcept {
+  return it + start;
+}
+
+// ...or are picked from the given row numbers
+template <class Iterator, class Row>
+row_iterator<Iterator, Row> select_values(Iterator it, const Row* rows) noexcept {
+  return {it, rows};
+}
+
+// Start is the row number of the first value or a pointer to row numbers
+template <class Index, class Axis, class IsGrowing, class Start = std::size_t>
 struct index_visitor {
   using index_type = Index;
   using pointer = index_type*;
@@ -67,42 +112,97 @@ struct index_visitor {
   using Opt = axis::traits::get_options<Axis>;
 
   Axis& axis_;
-  const std::size_t stride_, start_, size_; // start and size of value collection
+  const std::size_t stride_;
+  const Start start_;      // start of value collection or row numbers
+  const std::size_t size_; // size of value collection
   const pointer begin_;
   axis::index_type* shift_;
 
-  index_visitor(Axis& a, std::size_t& str, const std::size_t& sta, const std::size_t& si,
+  index_visitor(Axis& a, std::size_t& str, const Start& sta, const std::size_t& si,
                 const pointer it, axis::index_type* shift)
       : axis_(a), stride_(str), start_(sta), size_(si), begin_(it), shift_(shift) {}
 
+  // returns positive shift if the axis zero-point has changed
   template <class T>
-  void call_2(std::true_type, pointer it, const T& x) const {
+  axis::index_type call_2(std::true_type, pointer it, const T& x) const {
     // must use this code for all axes if one of them is growing
     axis::index_type shift;
     linearize_growth(*it, shift, stride_, axis_,
                      try_cast<value_type, std::invalid_argument>(x));
-    if (shift > 0) { // shift previous indices, because axis zero-point has changed
-      while (it != begin_) *--it += static_cast<std::size_t>(shift) * stride_;
-      *shift_ += shift;
-    }
+    if (shift > 0) *shift_ += shift;
+    return shift;
   }
 
   template <class T>
-  void call_2(std::false_type, pointer it, const T& x) const {
+  axis::index_type call_2(std::false_type, pointer it, const T& x) const {
     // no axis is growing
     linearize(*it, stride_, axis_, try_cast<value_type, std::invalid_argument>(x));
+    return 0;
+  }
+
+  using shifts_type = std::vector<std::pair<std::size_t, std::size_t>>;
+
+  // shift indices computed before each growth of the axis in a single backward pass
+  void apply_shifts(const shifts_type& shifts) const {
+    std::size_t sum = 0;
+    auto it = begin_ + shifts.back().first;
+    for (auto sit = shifts.rbegin(); sit != shifts.rend(); ++sit) {
+      for (const auto end = begin_ + sit->first; it != end;) *--it += sum;
+      sum += sit->second * stride_;
+    }
+    while (it != begin_) *--it += sum;
+  }
+
+  // Iterator is a pointer or an iterator over strided values
+  template <class Iterator>
+  void call_n(std::false_type, Iterator tp) const {
+    // positions and sizes of positive shifts, applying them immediately to all previous
+    // indices would make the fill quadratic in the number of values
+    shifts_type shifts;
+    for (auto it = begin_; it != begin_ + size_; ++it) {
+      const auto shift = call_2(IsGrowing{}, it, *tp++);
+      if (shift > 0)
+        shifts.emplace_back(static_cast<std::size_t>(it - begin_),
+                            static_cast<std::size_t>(shift));
+    }
+    if (!shifts.empty()) apply_shifts(shifts);
+  }
+
+  template <class T>
+  void call_n(std::true_type, const T* tp) const {
+    // axis computes a batch of indices at once, which is faster
+    constexpr std::size_t block = 1ul << 8;
+    axis::index_type idx[block];
+    constexpr auto opts = Opt{} & (axis::option::underflow | axis::option::overflow);
+    // if another axis is growing, the offset is zero and the underflow bin is added
+    // here, which gives the same result as linearize_growth for this axis
+    constexpr std::size_t uflow =
+        IsGrowing::value && Opt::test(axis::option::underflow) ? 1 : 0;
+    const auto size = axis_.size();
+    for (auto it = begin_; it != begin_ + size_;) {
+      const auto n = (std::min)(block, static_cast<std::size_t>(begin_ + size_ - it));
+      axis_.index_n(tp, n, idx);
+      tp += n;
+      for (auto&& i : make_span(idx, n)) {
+        *it += uflow * stride_;
+        linearize(opts, *it++, stride_, size, i);
+      }
+    }
   }
 
   template <class T>
   void call_1(std::false_type, const T& iterable) const {
     // T is iterable; fill N values
-    const auto* tp = dtl::data(iterable) + start_;
-    for (auto it = begin_; it != begin_ + size_; ++it) call_2(IsGrowing{}, it, *tp++);
+    auto tp = select_values(dtl::data(iterable), start_);
+    using E = std::remove_const_t<std::remove_pointer_t<decltype(tp)>>;
+    call_n(mp11::mp_bool<(!is_growing<Axis>::value && has_method_index_n<Axis>::value &&
+                          std::is_same<E, value_type>::value)>{},
+           tp);
   }
 
   template <class T>
   void call_1(std::true_type, const T& value) const {
-    // T is compatible value; fill single value N times
+    // T is compatible value; fill single value N times, delta includes any shift
     index_type idx{*begin_};
     call_2(IsGrowing{}, &idx, value);
     if (is_valid(idx)) {
@@ -121,8 +221,8 @@ struct index_visitor {
   }
 };
 
-template <class Index, class S, class Axes, class T>
-void fill_n_indices(Index* indices, const std::size_t start, const std::size_t size,
+template <class Index, class Start, class S, class Axes, class T>
+void fill_n_indices(Index* indices, const Start start, const std::size_t size,
                     const std::size_t offset, S& storage, Axes& axes, const T* viter) {
   axis::index_type extents[buffer_size<Axes>::value];
   axis::index_type shifts[buffer_size<Axes>::value];
@@ -138,7 +238,8 @@ void fill_n_indices(Index* indices, const std::size_t start, const std::size_t s
                        pshift = shifts](auto& axis) mutable {
     using Axis = std::decay_t<decltype(axis)>;
     maybe_visit(
-        index_visitor<Index, Axis, IsGrowing>{axis, stride, start, size, indices, pshift},
+        index_visitor<Index, Axis, IsGrowing, Start>{axis, stride, start, size, indices,
+                                                     pshift},
         *viter++);
     stride *= static_cast<std::size_t>(axis::traits::extent(axis));
     ++pshift;
@@ -161,7 +262,7 @@ void fill_n_storage(S& s, const Index idx, Ts&&... p) noexcept {
     BOOST_ASSERT(idx < s.size());
     fill_storage_element(s[idx], *p.first...);
   }
-  fold((p.second ? ++p.first : 0)...);
+  fold((p.second ? (++p.first, 0) : 0)...);
 }
 
 template <class S, class Index, class T, class... Ts>
@@ -171,15 +272,559 @@ void fill_n_storage(S& s, const Index idx, weight_type<T>&& w, Ts&&... ps) noexc
     fill_storage_element(s[idx], weight(*w.value.first), *ps.first...);
   }
   if (w.value.second) ++w.value.first;
-  fold((ps.second ? ++ps.first : 0)...);
+  fold((ps.second ? (++ps.first, 0) : 0)...);
+}
+
+template <class Iterator>
+decltype(auto) fill_n_arg(const std::pair<Iterator, std::size_t>& p,
+                          const std::size_t i) noexcept {
+  // sequences of length 0 are broadcast
+  return p.second ? p.first[i] : *p.first;
+}
+
+// random-access version of fill_n_storage, which does not advance the argument pointers
+template <class S, class Index, class... Ts>
+void fill_n_storage_at(S& s, const Index idx, const std::size_t i,
+                       const Ts&... p) noexcept {
+  BOOST_ASSERT(is_valid(idx) && idx < s.size());
+  boost::ignore_unused(i); // unused if there are no extra arguments
+  fill_storage_element(s[idx], fill_n_arg(p, i)...);
+}
+
+template <class S, class Index, class T, class... Ts>
+void fill_n_storage_at(S& s, const Index idx, const std::size_t i,
+                       const weight_type<T>& w, const Ts&... ps) noexcept {
+  BOOST_ASSERT(is_valid(idx) && idx < s.size());
+  fill_storage_element(s[idx], weight(fill_n_arg(w.value, i)), fill_n_arg(ps, i)...);
+}
+
+inline unsigned nthreads(const threads_type& t) noexcept {
+  // hardware_concurrency may return 0 if the value is not computable
+  const unsigned n = t.value ? t.value : std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+// calls f(k) for k = 0 .. n-1, where each call runs in its own thread
+template <class F>
+void run_in_threads(const unsigned n, F&& f) {
+  std::vector<std::exception_ptr> errors(n);
+  std::vector<std::thread> workers;
+  workers.reserve(n - 1);
+  auto guarded = [&f, &errors](unsigned k) {
+    BOOST_TRY { f(k); }
+    BOOST_CATCH(...) { errors[k] = std::current_exception(); }
+    BOOST_CATCH_END
+  };
+  for (unsigned k = 1; k < n; ++k) workers.emplace_back(guarded, k);
+  guarded(0); // main thread does its share of the work
+  for (auto&& w : workers) w.join();
+  for (auto&& e : errors)
+    if (e) std::rethrow_exception(e);
+}
+
+// reusable barrier for a fixed number of threads
+class thread_barrier {
+public:
+  explicit thread_barrier(const unsigned n) noexcept : n_(n) {}
+
+  // blocks until all threads have arrived
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto generation = generation_;
+    if (++count_ == n_) {
+      count_ = 0;
+      ++generation_;
+      cv_.notify_all();
+    } else {
+      cv_.wait(lock, [&] { return generation != generation_; });
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  const unsigned n_;
+  unsigned count_ = 0;
+  std::size_t generation_ = 0;
+};
+
+template <class T>
+struct is_soa_storage : std::false_type {};
+
+template <class T, class A>
+struct is_soa_storage<soa_storage<T, A>> : std::true_type {};
+
+// cells can be written concurrently as long as no two threads touch the same cell
+template <class S>
+using has_independent_cells =
+    mp11::mp_or<is_vector_like<S>, is_array_like<S>, is_soa_storage<S>>;
+
+/*
+  Parallel fill, option C) from the notes in fill_n_nd.
+
+  The index range [0, storage.size()) is cut into nthreads * blocks_per_thread
+  contiguous blocks. For each chunk of values, the threads first compute the indices for
+  a slice of the chunk and count how many indices fall into each block. The row numbers
+  are then bucket-sorted by block, preserving the original order within each block.
+  Finally, each thread fills the cells of a contiguous range of blocks. The ranges are
+  chosen from the counts so that each thread gets about the same number of values, even
+  if the data is peaked, but the values of one block always go to one thread. No two
+  threads touch the same cell, so no synchronization of the storage is needed, and each
+  cell sees the values in the same order as in the serial fill, which gives
+  bit-identical results for floating point cells.
+
+  The workers are started once per call and wait for each other at a barrier between
+  the phases. Computing indices throws if a value cannot be converted to the value type
+  of the axis. The worker then still waits at the barrier, so that the others are not
+  blocked, and all workers leave together after the barrier. The exception is rethrown
+  in the calling thread. Filling cells does not throw.
+*/
+template <class Index, class S, class A, class T, class... Ts>
+void fill_n_nd_parallel(const unsigned nthreads, const std::size_t offset, S& storage,
+                        A& axes, const std::size_t vsize, const T* values,
+                        const Ts&... ts) {
+  constexpr std::size_t buffer_size_per_thread = 1ul << 16;
+  constexpr std::size_t blocks_per_thread = 8;
+  const std::size_t buffer_size = (std::min)(nthreads * buffer_size_per_thread, vsize);
+  const std::size_t nblocks =
+      (std::min)(nthreads * blocks_per_thread, std::size_t{storage.size()});
+  const std::size_t block = (storage.size() + nblocks - 1) / nblocks;
+  std::vector<Index> indices(buffer_size);
+  std::vector<std::size_t> rows(buffer_size);
+  // pos[k * nblocks + b]: count, then write position of rows in block b from thread k
+  std::vector<std::size_t> pos(nthreads * nblocks);
+  // rows of thread k in phase 3 are [row_begin[k], row_begin[k + 1])
+  std::vector<std::size_t> row_begin(nthreads + 1);
+  thread_barrier barrier(nthreads);
+  std::atomic<bool> failed{false};
+
+  run_in_threads(nthreads, [&](const unsigned k) {
+    std::exception_ptr error;
+    for (std::size_t start = 0; start < vsize; start += buffer_size) {
+      const std::size_t n = (std::min)(buffer_size, vsize - start);
+      const std::size_t slice = (n + nthreads - 1) / nthreads;
+      auto slice_begin = [n, slice](unsigned j) { return (std::min)(n, j * slice); };
+
+      // fill buffer of indices and count indices per block...
+      {
+        const auto b = slice_begin(k);
+        const auto e = slice_begin(k + 1);
+        auto cit = pos.begin() + k * nblocks;
+        std::fill(cit, cit + nblocks, 0);
+        BOOST_TRY {
+          if (b != e)
+            fill_n_indices(indices.data() + b, start + b, e - b, offset, storage, axes,
+                           values);
+          for (auto&& idx : make_span(indices.data() + b, e - b))
+            if (is_valid(idx)) ++cit[idx / block];
+        }
+        BOOST_CATCH(...) {
+          error = std::current_exception();
+          failed = true;
+        }
+        BOOST_CATCH_END
+      }
+      barrier.wait();
+      // only the first phase throws, so all workers leave here together
+      if (failed) break;
+
+      // ...convert counts to write positions and balance the blocks...
+      if (k == 0) {
+        std::size_t total = 0;
+        for (auto&& c : pos) total += c;
+        std::size_t sum = 0;
+        unsigned j = 1;
+        for (std::size_t b = 0; b < nblocks; ++b) {
+          for (unsigned i = 0; i < nthreads; ++i) {
+            auto& p = pos[i * nblocks + b];
+            const auto count = p;
+            p = sum;
+            sum += count;
+          }
+          // rows of thread j start after block b, if the rows before are its share
+          for (; j < nthreads && sum * nthreads >= j * total; ++j) row_begin[j] = sum;
+        }
+        for (; j <= nthreads; ++j) row_begin[j] = sum;
+      }
+      barrier.wait();
+
+      // ...sort row numbers by block...
+      {
+        auto pit = pos.begin() + k * nblocks;
+        for (auto i = slice_begin(k), e = slice_begin(k + 1); i != e; ++i) {
+          const auto idx = indices[i];
+          if (is_valid(idx)) rows[pit[idx / block]++] = i;
+        }
+      }
+      barrier.wait();
+
+      // ...and fill the cells of each range of blocks in its own thread
+      for (auto&& i :
+           make_span(rows.data() + row_begin[k], rows.data() + row_begin[k + 1]))
+        fill_n_storage_at(storage, indices[i], start + i, ts...);
+      // buffers are overwritten by the next chunk
+      barrier.wait();
+    }
+    if (error) std::rethrow_exception(error);
+  });
+}
+
+// 1D fill of integral counters without weights or samples
+template <class S, class A, class... Ts>
+using can_use_subcounters = mp11::mp_bool<(
+    sizeof...(Ts) == 0 && has_independent_cells<S>::value &&
+    std::is_integral<typename S::value_type>::value &&
+    !std::is_same<typename S::value_type, bool>::value && is_tuple<A>::value &&
+    mp11::mp_size<A>::value == 1 && !has_growing_axis<A>::value)>;
+
+template <class Index, class... Ts>
+bool fill_n_subcounters(std::false_type, const Ts&...) noexcept {
+  return false;
+}
+
+/*
+  Increments of the same cell in consecutive iterations stall on the store-to-load
+  dependency, which happens all the time if the data is peaked. Consecutive increments
+  are therefore spread over several private arrays of sub-counters, which are merged
+  into the storage at the end. The sub-counters fit into the L1 cache, so this is only
+  used for small storages and if there are enough values to amortize the merge.
+*/
+template <class Index, class S, class A, class T>
+bool fill_n_subcounters(std::true_type, const std::size_t offset, S& storage, A& axes,
+                        const std::size_t vsize, const T* values) {
+  constexpr std::size_t nsub = 8;
+  constexpr std::size_t max_size = 1ul << 10;
+  constexpr std::size_t buffer_size = 1ul << 12;
+  constexpr std::size_t max_count = (std::numeric_limits<std::uint32_t>::max)();
+  const std::size_t size = storage.size();
+  if (size > max_size || vsize < 4 * size) return false;
+
+  // invalid indices are counted in the extra cell at the end and discarded
+  const std::size_t stride = size + 1;
+  std::uint32_t counts[nsub * (max_size + 1)];
+  std::fill(counts, counts + nsub * stride, 0);
+  auto merge = [&] {
+    for (std::size_t j = 0; j < size; ++j) {
+      std::size_t c = 0;
+      for (std::size_t k = 0; k < nsub; ++k) {
+        c += counts[k * stride + j];
+        counts[k * stride + j] = 0;
+      }
+      storage[j] += static_cast<typename S::value_type>(c);
+    }
+  };
+
+  Index indices[buffer_size];
+  std::size_t pending = 0;
+  for (std::size_t start = 0; start < vsize; start += buffer_size) {
+    const std::size_t n = (std::min)(buffer_size, vsize - start);
+    if (pending > max_count - n) {
+      merge();
+      pending = 0;
+    }
+    pending += n;
+    fill_n_indices(indices, start, n, offset, storage, axes, values);
+    auto iit = indices;
+    for (const auto iend = indices + n - n % nsub; iit != iend; iit += nsub)
+      for (std::size_t k = 0; k < nsub; ++k)
+        ++counts[k * stride + (std::min)(static_cast<std::size_t>(iit[k]), size)];
+    for (; iit != indices + n; ++iit)
+      ++counts[(std::min)(static_cast<std::size_t>(*iit), size)];
+  }
+  merge();
+  return true;
+}
+
+// cells can be prefetched if they are independent and accessed by reference
+template <class S>
+using has_prefetchable_cells =
+    mp11::mp_and<has_independent_cells<S>,
+                  std::is_lvalue_reference<decltype(std::declval<S&>()[0])>>;
+
+inline void prefetch_for_write(const void* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p, 1);
+#else
+  boost::ignore_unused(p);
+#endif
+}
+
+template <class S>
+std::size_t fill_n_prefetch_distance(std::false_type, const S&,
+                                     const fill_tuning&) noexcept {
+  return 0;
+}
+
+// prefetching only pays off if the cells do not fit into the cache
+template <class S>
+std::size_t fill_n_prefetch_distance(std::true_type, const S& storage,
+                                     const fill_tuning& tuning) noexcept {
+  constexpr std::size_t cache_size = 1ul << 20;
+  return storage.size() * sizeof(typename S::value_type) > cache_size
+             ? tuning.prefetch_distance
+             : 0;
+}
+
+template <class S, class Index>
+void fill_n_prefetch(std::false_type, S&, const Index) noexcept {}
+
+template <class S, class Index>
+void fill_n_prefetch(std::true_type, S& s, const Index idx) noexcept {
+  if (is_valid(idx)) {
+    BOOST_ASSERT(idx < s.size());
+    prefetch_for_write(&s[idx]);
+  }
+}
+
+template <class S, class Index, class... Ts>
+void fill_n_scatter_each(S& s, const Index* indices, const std::size_t n,
+                         const std::size_t distance, Ts&&... ts) {
+  auto it = indices;
+  const auto end = indices + n;
+  if (distance > 0 && distance < n) {
+    for (const auto pend = end - distance; it != pend; ++it) {
+      fill_n_prefetch(has_prefetchable_cells<S>{}, s, it[distance]);
+      fill_n_storage(s, *it, std::forward<Ts>(ts)...);
+    }
+  }
+  for (; it != end; ++it) fill_n_storage(s, *it, std::forward<Ts>(ts)...);
+}
+
+template <class S, class Index, class... Ts>
+void fill_n_scatter(S& s, const Index* indices, const std::size_t n,
+                    const std::size_t distance, Ts&&... ts) {
+  fill_n_scatter_each(s, indices, n, distance, std::forward<Ts>(ts)...);
+}
+
+template <class T>
+struct is_accurate_sum : std::false_type {};
+
+template <class T>
+struct is_accurate_sum<accumulators::sum<T>> : std::true_type {};
+
+template <class S>
+using has_accurate_sum_cells =
+    mp11::mp_and<has_independent_cells<S>, is_accurate_sum<typename S::value_type>>;
+
+/*
+  Each weighted fill of accumulators::sum runs a compensated addition, whose chain of
+  dependent operations stalls if consecutive weights go to the same cell, which happens
+  all the time if the data is peaked. If the chunk is large compared to the storage,
+  consecutive weights are therefore added to different arrays of partial sums, as in
+  fill_n_subcounters, and the partial sums are added to the cells at the end. The
+  partial sums are accumulators::sum as well, so no precision is lost and large weights
+  which cancel each other do not wipe out small ones.
+*/
+template <class S, class Index, class T>
+std::enable_if_t<has_accurate_sum_cells<S>::value> fill_n_scatter(
+    S& s, const Index* indices, const std::size_t n, const std::size_t distance,
+    weight_type<std::pair<const T*, std::size_t>>&& w) {
+  constexpr std::size_t nsub = 4;
+  const std::size_t size = s.size();
+  if (size * nsub > n) return fill_n_scatter_each(s, indices, n, distance, std::move(w));
+
+  std::vector<typename S::value_type> partial(nsub * size);
+  const T* wit = w.value.first;
+  const std::size_t step = w.value.second ? 1 : 0;
+  auto add = [&](const std::size_t k, const Index idx) {
+    if (is_valid(idx)) partial[k * size + static_cast<std::size_t>(idx)] += *wit;
+    wit += step;
+  };
+  auto it = indices;
+  for (const auto end = indices + n - n % nsub; it != end; it += nsub)
+    for (std::size_t k = 0; k < nsub; ++k) add(k, it[k]);
+  for (const auto end = indices + n; it != end; ++it) add(0, *it);
+  w.value.first = wit;
+
+  for (std::size_t i = 0; i < size; ++i) {
+    auto&& cell = s[i];
+    for (std::size_t k = 0; k < nsub; ++k) cell += partial[k * size + i];
+  }
+}
+
+template <class T>
+struct is_mean : std::false_type {};
+
+template <class T>
+struct is_mean<accumulators::mean<T>> : std::true_type {};
+
+template <class T>
+struct is_weighted_mean : std::false_type {};
+
+template <class T>
+struct is_weighted_mean<accumulators::weighted_mean<T>> : std::true_type {};
+
+template <class S>
+using has_mean_cells =
+    mp11::mp_and<has_independent_cells<S>, is_mean<typename S::value_type>>;
+
+template <class S>
+using has_weighted_mean_cells =
+    mp11::mp_and<has_independent_cells<S>, is_weighted_mean<typename S::value_type>>;
+
+// accumulator for the samples of one cell in a chunk, from the sum of weights, the sum
+// of weights squared, the mean, and the sum of weighted squared deltas
+template <class T>
+accumulators::mean<T> make_sample_group(const accumulators::mean<T>&, const T w,
+                                        const T, const T m, const T d2) noexcept {
+  return {w, m, w > 1 ? d2 / (w - 1) : T{0}};
+}
+
+template <class T>
+accumulators::weighted_mean<T> make_sample_group(const accumulators::weighted_mean<T>&,
+                                                 const T w, const T w2, const T m,
+                                                 const T d2) noexcept {
+  const T n = w - w2 / w;
+  return {w, w2, m, n != 0 ? d2 / n : T{0}};
+}
+
+/*
+  Each sample which is added to a mean or weighted_mean updates the mean with a division
+  and then the sum of squared deltas with the new mean, which is a long dependency chain
+  per sample. If the chunk is large compared to the storage, the samples are grouped by
+  cell instead. A first pass computes the sum of weights and the mean of each group, a
+  second pass the sum of squared deltas to this mean. Each group is then added to its
+  cell with the parallel algorithm of Chan et al. in operator+= of the accumulator. The
+  passes only add to independent sums, and the result is the same as with sequential
+  updates up to rounding.
+*/
+template <class S, class Index, class Weight, class T>
+void fill_n_sample_groups(S& s, const Index* indices, const std::size_t n, Weight w,
+                          std::pair<const T*, std::size_t>& x) {
+  using cell_type = typename S::value_type;
+  using value_type = typename cell_type::value_type;
+  const std::size_t size = s.size();
+  std::vector<value_type> buffer(4 * size);
+  auto sw = buffer.data();
+  auto sw2 = sw + size;
+  auto mean = sw2 + size;
+  auto d2 = mean + size;
+  const std::size_t step = x.second ? 1 : 0;
+
+  auto xit = x.first;
+  for (std::size_t i = 0; i < n; ++i, xit += step) {
+    if (!is_valid(indices[i])) continue;
+    const auto k = static_cast<std::size_t>(indices[i]);
+    const auto wi = static_cast<value_type>(w(i));
+    sw[k] += wi;
+    sw2[k] += wi * wi;
+    mean[k] += wi * static_cast<value_type>(*xit);
+  }
+  for (std::size_t k = 0; k < size; ++k)
+    if (sw[k] != 0) mean[k] /= sw[k];
+
+  xit = x.first;
+  for (std::size_t i = 0; i < n; ++i, xit += step) {
+    if (!is_valid(indices[i])) continue;
+    const auto k = static_cast<std::size_t>(indices[i]);
+    const auto delta = static_cast<value_type>(*xit) - mean[k];
+    d2[k] += static_cast<value_type>(w(i)) * delta * delta;
+  }
+  x.first = xit;
+
+  for (std::size_t k = 0; k < size; ++k) {
+    if (sw[k] == 0) continue;
+    auto&& cell = s[k];
+    cell += make_sample_group(static_cast<const cell_type&>(cell), sw[k], sw2[k],
+                              mean[k], d2[k]);
+  }
+}
+
+// profile, samples are grouped by cell if the chunk is large enough
+template <class S, class Index, class T>
+std::enable_if_t<(has_mean_cells<S>::value || has_weighted_mean_cells<S>::value)>
+fill_n_scatter(S& s, const Index* indices, const std::size_t n,
+               const std::size_t distance, std::pair<const T*, std::size_t>&& x) {
+  constexpr std::size_t min_per_cell = 4;
+  if (s.size() * min_per_cell > n)
+    return fill_n_scatter_each(s, indices, n, distance, std::move(x));
+  fill_n_sample_groups(s, indices, n, [](std::size_t) { return 1; }, x);
+}
+
+// weighted profile, samples are grouped by cell if the chunk is large enough
+template <class S, class Index, class W, class T>
+std::enable_if_t<has_weighted_mean_cells<S>::value> fill_n_scatter(
+    S& s, const Index* indices, const std::size_t n, const std::size_t distance,
+    weight_type<std::pair<const W*, std::size_t>>&& w,
+    std::pair<const T*, std::size_t>&& x) {
+  constexpr std::size_t min_per_cell = 4;
+  if (s.size() * min_per_cell > n)
+    return fill_n_scatter_each(s, indices, n, distance, std::move(w), std::move(x));
+  const auto wp = w.value.first;
+  const std::size_t wstep = w.value.second ? 1 : 0;
+  fill_n_sample_groups(
+      s, indices, n, [wp, wstep](std::size_t i) { return wp[i * wstep]; }, x);
+  w.value.first += n * wstep;
+}
+
+// unweighted fills of unlimited_storage check for overflow once per chunk, not per cell
+template <class A, class Index>
+void fill_n_scatter(unlimited_storage<A>& s, const Index* indices, const std::size_t n,
+                    const std::size_t) {
+  s.increment_n(indices, n);
+}
+
+// unweighted fills of sparse_storage grow the table at most once per chunk
+template <class T, class A, class Index>
+void fill_n_scatter(sparse_storage<T, A>& s, const Index* indices, const std::size_t n,
+                    const std::size_t) {
+  s.increment_n(indices, n);
+}
+
+template <class T, std::size_t N, class A, class Index>
+void fill_n_scatter(paged_storage<T, N, A>& s, const Index* indices, const std::size_t n,
+                    const std::size_t) {
+  s.increment_n(indices, n);
+}
+
+template <class T, std::size_t N, class A, class Index>
+void fill_n_scatter(sharded_storage<T, N, A>& s, const Index* indices,
+                    const std::size_t n, const std::size_t) {
+  s.increment_n(indices, n);
+}
+
+// chunk goes into one buffer, which is entered once
+template <class S, class Index, class... Ts>
+void fill_n_scatter(double_buffered_storage<S>& s, const Index* indices,
+                    const std::size_t n, const std::size_t distance, Ts&&... ts) {
+  s.write(
+      [&](S& b) { fill_n_scatter(b, indices, n, distance, std::forward<Ts>(ts)...); });
+}
+
+constexpr std::size_t index_buffer_stack_size = 1ul << 14;
+
+// separate function, so that the caller has no stack array if the buffer is on the heap
+template <class T, class F>
+BOOST_NOINLINE void with_stack_buffer(F& f) {
+  T buffer[index_buffer_stack_size];
+  f(buffer);
+}
+
+// calls f with a buffer of the given size, which is on the stack unless it is larger
+// than the default buffer size
+template <class T, class F>
+void with_index_buffer(const std::size_t size, F&& f) {
+  BOOST_ASSERT(size > 0);
+  if (size > index_buffer_stack_size) {
+    std::vector<T> buffer(size);
+    f(buffer.data());
+  } else {
+    with_stack_buffer<T>(f);
+  }
 }
 
 // general Nd treatment
 template <class Index, class S, class A, class T, class... Ts>
-void fill_n_nd(const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
+void fill_n_nd(mp11::mp_false, const unsigned, const fill_tuning& tuning,
+               const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
                const T* values, Ts&&... ts) {
-  constexpr std::size_t buffer_size = 1ul << 14;
-  Index indices[buffer_size];
+  if (fill_n_subcounters<Index>(can_use_subcounters<S, A, Ts...>{}, offset, storage,
+                                axes, vsize, values, ts...))
+    return;
+
+  const std::size_t buffer_size = tuning.buffer_size;
+  const std::size_t distance =
+      fill_n_prefetch_distance(has_prefetchable_cells<S>{}, storage, tuning);
 
   /*
     Parallelization options.
@@ -207,28 +852,133 @@ void fill_n_nd(const std::size_t offset, S& storage, A& axes, const std::size_t
     compete to increment the same cell, no further synchronization is required.
 
     In all cases, growing axes cannot be parallelized.
+
+    Option C) is implemented in fill_n_nd_parallel, with a bucket sort instead of a
+    full sort, and is used if the user requests more than one thread.
   */
 
-  for (std::size_t start = 0; start < vsize; start += buffer_size) {
-    const std::size_t n = std::min(buffer_size, vsize - start);
-    // fill buffer of indices...
-    fill_n_indices(indices, start, n, offset, storage, axes, values);
-    // ...and fill corresponding storage cells
-    for (auto&& idx : make_span(indices, n))
-      fill_n_storage(storage, idx, std::forward<Ts>(ts)...);
+  with_index_buffer<Index>(buffer_size, [&](Index* indices) {
+    for (std::size_t start = 0; start < vsize; start += buffer_size) {
+      const std::size_t n = (std::min)(buffer_size, vsize - start);
+      // fill buffer of indices...
+      fill_n_indices(indices, start, n, offset, storage, axes, values);
+      // ...and fill corresponding storage cells
+      fill_n_scatter(storage, indices, n, distance, std::forward<Ts>(ts)...);
+    }
+  });
+}
+
+template <class Index, class S, class A, class T, class... Ts>
+void fill_n_nd(mp11::mp_true, const unsigned nthreads, const fill_tuning& tuning,
+               const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
+               const T* values, Ts&&... ts) {
+  if (nthreads > 1)
+    fill_n_nd_parallel<Index>(nthreads, offset, storage, axes, vsize, values, ts...);
+  else
+    fill_n_nd<Index>(mp11::mp_false{}, nthreads, tuning, offset, storage, axes, vsize,
+                     values, std::forward<Ts>(ts)...);
+}
+
+// all rows are filled
+struct no_selection {};
+
+template <class T>
+struct is_selection : std::false_type {};
+
+template <class T>
+struct is_selection<mask_type<T>> : std::true_type {};
+
+template <class T>
+struct is_selection<rows_type<T>> : std::true_type {};
+
+template <class T, class = std::enable_if_t<is_selection<T>::value>>
+struct requires_selection {};
+
+template <class Index, class S, class A, class T, class... Ts>
+void fill_n_nd(const unsigned nthreads, const fill_tuning& tuning, no_selection,
+               const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
+               const T* values, Ts&&... ts) {
+  using can_run_parallel =
+      mp11::mp_bool<(has_independent_cells<S>::value && !has_growing_axis<A>::value)>;
+  fill_n_nd<Index>(can_run_parallel{}, nthreads, tuning, offset, storage, axes, vsize,
+                   values, std::forward<Ts>(ts)...);
+}
+
+// fill only the given rows, weights and samples are picked from the same rows
+template <class Index, class Row, class S, class A, class T, class... Ts>
+void fill_n_rows(Index* indices, const Row* rows, const std::size_t n,
+                 const std::size_t offset, S& storage, A& axes, const T* values,
+                 const Ts&... ts) {
+  fill_n_indices(indices, rows, n, offset, storage, axes, values);
+  for (std::size_t k = 0; k < n; ++k) {
+    if (is_valid(indices[k]))
+      fill_n_storage_at(storage, indices[k], static_cast<std::size_t>(rows[k]), ts...);
   }
 }
 
-template <class S, class... As, class T, class... Us>
-void fill_n_1(const std::size_t offset, S& storage, std::tuple<As...>& axes,
+/*
+  Selections are filled serially. The indices are only computed for the selected rows,
+  so skipped rows cost almost nothing. A mask is converted chunk-wise into a buffer of
+  row numbers, which is on the heap, so that only the buffer of indices is on the stack.
+*/
+template <class Index, class M, class S, class A, class T, class... Ts>
+void fill_n_nd(const unsigned, const fill_tuning& tuning, const mask_type<M>& sel,
+               const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
+               const T* values, const Ts&... ts) {
+  const auto mask = dtl::data(sel.value);
+  if (static_cast<std::size_t>(dtl::size(sel.value)) != vsize)
+    BOOST_THROW_EXCEPTION(std::invalid_argument("spans must have compatible lengths"));
+
+  const std::size_t buffer_size = tuning.buffer_size;
+  std::vector<std::size_t> rows((std::min)(buffer_size, vsize));
+  with_index_buffer<Index>(buffer_size, [&](Index* indices) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < vsize; ++i) {
+      // branch-free, overwritten by next selected row if mask is false
+      rows[n] = i;
+      n += static_cast<bool>(mask[i]);
+      if (n == buffer_size) {
+        fill_n_rows(indices, rows.data(), n, offset, storage, axes, values, ts...);
+        n = 0;
+      }
+    }
+    if (n > 0) fill_n_rows(indices, rows.data(), n, offset, storage, axes, values, ts...);
+  });
+}
+
+template <class Index, class R, class S, class A, class T, class... Ts>
+void fill_n_nd(const unsigned, const fill_tuning& tuning, const rows_type<R>& sel,
+               const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
+               const T* values, const Ts&... ts) {
+  const auto rows = dtl::data(sel.value);
+  const auto nrows = static_cast<std::size_t>(dtl::size(sel.value));
+  // negative row numbers are converted to large positive numbers
+  for (auto&& r : make_span(rows, nrows))
+    if (static_cast<std::size_t>(r) >= vsize)
+      BOOST_THROW_EXCEPTION(std::out_of_range("row number out of range"));
+
+  const std::size_t buffer_size = tuning.buffer_size;
+  with_index_buffer<Index>(buffer_size, [&](Index* indices) {
+    for (std::size_t start = 0; start < nrows; start += buffer_size) {
+      const std::size_t n = (std::min)(buffer_size, nrows - start);
+      fill_n_rows(indices, rows + start, n, offset, storage, axes, values, ts...);
+    }
+  });
+}
+
+template <class Sel, class S, class... As, class T, class... Us>
+void fill_n_1(const unsigned nthreads, const fill_tuning& tuning, const Sel& sel,
+              const std::size_t offset, S& storage, std::tuple<As...>& axes,
               const std::size_t vsize, const T* values, Us&&... us) {
   using index_type =
       mp11::mp_if<has_non_inclusive_axis<std::tuple<As...>>, optional_index, std::size_t>;
-  fill_n_nd<index_type>(offset, storage, axes, vsize, values, std::forward<Us>(us)...);
+  fill_n_nd<index_type>(nthreads, tuning, sel, offset, storage, axes, vsize, values,
+                        std::forward<Us>(us)...);
 }
 
-template <class S, class A, class T, class... Us>
-void fill_n_1(const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
+template <class Sel, class S, class A, class T, class... Us>
+void fill_n_1(const unsigned nthreads, const fill_tuning& tuning, const Sel& sel,
+              const std::size_t offset, S& storage, A& axes, const std::size_t vsize,
               const T* values, Us&&... us) {
   bool all_inclusive = true;
   for_each_axis(axes,
@@ -237,16 +987,17 @@ void fill_n_1(const std::size_t offset, S& storage, A& axes, const std::size_t v
     axis::visit(
         [&](auto& ax) {
           std::tuple<decltype(ax)> axes{ax};
-          fill_n_1(offset, storage, axes, vsize, values, std::forward<Us>(us)...);
+          fill_n_1(nthreads, tuning, sel, offset, storage, axes, vsize, values,
+                   std::forward<Us>(us)...);
         },
         axes[0]);
   } else {
     if (all_inclusive)
-      fill_n_nd<std::size_t>(offset, storage, axes, vsize, values,
+      fill_n_nd<std::size_t>(nthreads, tuning, sel, offset, storage, axes, vsize, values,
                              std::forward<Us>(us)...);
     else
-      fill_n_nd<optional_index>(offset, storage, axes, vsize, values,
-                                std::forward<Us>(us)...);
+      fill_n_nd<optional_index>(nthreads, tuning, sel, offset, storage, axes, vsize,
+                                values, std::forward<Us>(us)...);
   }
 }
 
@@ -300,8 +1051,9 @@ void fill_n_check_extra_args(std::size_t size, weight_type<T>&& w, Ts&&... ts) {
   fill_n_check_extra_args(size, w.value, std::forward<Ts>(ts)...);
 }
 
-template <class S, class A, class T, std::size_t N, class... Us>
-void fill_n(std::true_type, const std::size_t offset, S& storage, A& axes,
+template <class Sel, class S, class A, class T, std::size_t N, class... Us>
+void fill_n(std::true_type, const unsigned nthreads, const fill_tuning& tuning,
+            const Sel& sel, const std::size_t offset, S& storage, A& axes,
             const dtl::span<const T, N> values, Us&&... us) {
   // supported cases (T = value type; CT = containter of T; V<T, CT, ...> = variant):
   // - span<T, N>: only valid for 1D histogram, N > 1 allowed
@@ -314,7 +1066,8 @@ void fill_n(std::true_type, const std::size_t offset, S& storage, A& axes,
           BOOST_THROW_EXCEPTION(
               std::invalid_argument("number of arguments must match histogram rank"));
         fill_n_check_extra_args(values.size(), std::forward<Us>(us)...);
-        fill_n_1(offset, storage, axes, values.size(), &values, std::forward<Us>(us)...);
+        fill_n_1(nthreads, tuning, sel, offset, storage, axes, values.size(), &values,
+                 std::forward<Us>(us)...);
       },
       [&](const auto& values, auto&&... us) {
         // generic ND case
@@ -323,7 +1076,8 @@ void fill_n(std::true_type, const std::size_t offset, S& storage, A& axes,
               std::invalid_argument("number of arguments must match histogram rank"));
         const auto vsize = get_total_size(axes, values);
         fill_n_check_extra_args(vsize, std::forward<Us>(us)...);
-        fill_n_1(offset, storage, axes, vsize, values.data(), std::forward<Us>(us)...);
+        fill_n_1(nthreads, tuning, sel, offset, storage, axes, vsize, values.data(),
+                 std::forward<Us>(us)...);
       },
       values, std::forward<Us>(us)...);
 }
@@ -0,0 +1,121 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_DETAIL_HASH_INDEX_HPP
+#define BOOST_HISTOGRAM_DETAIL_HASH_INDEX_HPP
+
+#include <algorithm>
+#include <boost/histogram/fwd.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+// Finds position of a value in a vector with std::find; has no state.
+struct linear_index {
+  template <class Allocator>
+  explicit linear_index(const Allocator&) noexcept {}
+  linear_index() = default;
+
+  template <class Vector, class T>
+  axis::index_type find(const Vector& vec, const T& x) const noexcept {
+    const auto beg = vec.begin();
+    const auto end = vec.end();
+    return static_cast<axis::index_type>(std::distance(beg, std::find(beg, end, x)));
+  }
+
+  template <class Vector>
+  void build(const Vector&) noexcept {}
+
+  template <class Vector>
+  void push_back(const Vector&) noexcept {}
+};
+
+/*
+  Finds position of a value in a vector with an open-addressing hash table, which maps
+  values to positions. The table only holds positions, the values stay in the vector,
+  and must be kept in sync by calling build() after arbitrary changes or push_back()
+  after appending a value to the vector.
+
+  The table uses linear probing and a load factor of at most 1/2. The hash is
+  scrambled with a Fibonacci multiplier, since std::hash is the identity for
+  integers in common implementations.
+*/
+template <class Allocator>
+class hash_index {
+  using table_type = std::vector<
+      axis::index_type,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<axis::index_type>>;
+
+public:
+  explicit hash_index(const Allocator& a = {}) : table_(a) {}
+
+  // returns vec.size() if x is not found
+  template <class Vector, class T>
+  axis::index_type find(const Vector& vec, const T& x) const noexcept {
+    if (table_.empty()) return static_cast<axis::index_type>(vec.size());
+    for (auto k = slot(x);; k = (k + 1) & (table_.size() - 1)) {
+      const auto i = table_[k];
+      if (i < 0) return static_cast<axis::index_type>(vec.size());
+      if (vec[i] == x) return i;
+    }
+  }
+
+  template <class Vector>
+  void build(const Vector& vec) {
+    table_.clear();
+    if (vec.empty()) return;
+    shift_ = 64;
+    std::size_t n = 1;
+    while (n < 2 * vec.size()) {
+      n *= 2;
+      --shift_;
+    }
+    table_.resize(n, -1);
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+      // for duplicated values, the first position is found, like with std::find
+      if (static_cast<std::size_t>(find(vec, vec[i])) == vec.size())
+        insert(vec, static_cast<axis::index_type>(i));
+    }
+  }
+
+  // update table after a new value was appended to vec
+  template <class Vector>
+  void push_back(const Vector& vec) {
+    if (2 * vec.size() > table_.size())
+      build(vec);
+    else
+      insert(vec, static_cast<axis::index_type>(vec.size() - 1));
+  }
+
+private:
+  template <class T>
+  std::size_t slot(const T& x) const noexcept {
+    const std::uint64_t h = std::hash<T>{}(x);
+    return static_cast<std::size_t>((h * 11400714819323198485ull) >> shift_);
+  }
+
+  template <class Vector>
+  void insert(const Vector& vec, axis::index_type i) {
+    auto k = slot(vec[i]);
+    while (table_[k] >= 0) k = (k + 1) & (table_.size() - 1);
+    table_[k] = i;
+  }
+
+  table_type table_;
+  unsigned shift_ = 64;
+};
+
+} // namespace detail
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -75,6 +75,27 @@ std::size_t linearize_growth(Index& out, axis::index_type& shift,
   return axis::traits::extent(a);
 }
 
+// like linearize_growth, but only reads the axis; returns zero if the axis would grow
+template <class Index, class Axis, class Value>
+std::size_t linearize_no_growth(Index& out, const std::size_t stride, const Axis& a,
+                                const Value& v) {
+  auto idx = axis::traits::index(a, v);
+  constexpr auto opts = axis::traits::get_options<Axis>{};
+  // values outside of a growing axis may grow it, even if there are flow bins
+  if (opts.test(axis::option::growth) && (idx < 0 || idx >= a.size())) return 0;
+  if (opts.test(axis::option::underflow)) ++idx;
+  if (std::is_same<Index, std::size_t>::value) {
+    BOOST_ASSERT(idx < axis::traits::extent(a));
+    out += idx * stride;
+  } else {
+    if (0 <= idx && idx < axis::traits::extent(a))
+      out += idx * stride;
+    else
+      out = invalid_index;
+  }
+  return axis::traits::extent(a);
+}
+
 // initial offset of out must be zero
 template <class A>
 std::size_t linearize_index(optional_index& out, const std::size_t stride, const A& ax,
@@ -104,6 +125,12 @@ std::size_t linearize_growth(Index& o, axis::index_type& sh, const std::size_t s
   return axis::visit([&](auto& a) { return linearize_growth(o, sh, st, a, v); }, a);
 }
 
+template <class Index, class... Ts, class Value>
+std::size_t linearize_no_growth(Index& o, const std::size_t s,
+                                const axis::variant<Ts...>& a, const Value& v) {
+  return axis::visit([&](const auto& a) { return linearize_no_growth(o, s, a, v); }, a);
+}
+
 } // namespace detail
 } // namespace histogram
 } // namespace boost
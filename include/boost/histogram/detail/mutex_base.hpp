@@ -7,10 +7,12 @@
 #ifndef BOOST_HISTOGRAM_DETAIL_NOOP_MUTEX_HPP
 #define BOOST_HISTOGRAM_DETAIL_NOOP_MUTEX_HPP
 
+#include <atomic>
 #include <boost/core/empty_value.hpp>
 #include <boost/histogram/detail/axes.hpp>
 #include <boost/mp11/utility.hpp> // mp_if
 #include <mutex>
+#include <thread>
 
 namespace boost {
 namespace histogram {
@@ -20,12 +22,52 @@ struct null_mutex {
   bool try_lock() noexcept { return true; }
   void lock() noexcept {}
   void unlock() noexcept {}
+  void lock_shared() noexcept {}
+  void unlock_shared() noexcept {}
+};
+
+/*
+  Readers-writer lock for thread-safe histograms with growing axes.
+
+  Fills which do not grow an axis take the lock in shared mode, which only increments
+  and decrements a counter, so they run concurrently. A fill which grows an axis takes
+  the lock in exclusive mode. It waits until the running fills are done and holds back
+  new ones until the axes and the storage are updated.
+*/
+class growth_mutex {
+public:
+  void lock_shared() noexcept {
+    while (state_.fetch_add(1, std::memory_order_acquire) & writer) {
+      // a writer is active or waiting, step back until it is done
+      state_.fetch_sub(1, std::memory_order_relaxed);
+      while (state_.load(std::memory_order_relaxed) & writer) std::this_thread::yield();
+    }
+  }
+
+  void unlock_shared() noexcept { state_.fetch_sub(1, std::memory_order_release); }
+
+  void lock() {
+    writers_.lock();
+    state_.fetch_or(writer, std::memory_order_acquire);
+    while (state_.load(std::memory_order_acquire) != writer) std::this_thread::yield();
+  }
+
+  void unlock() {
+    state_.fetch_and(~writer, std::memory_order_release);
+    writers_.unlock();
+  }
+
+private:
+  static constexpr unsigned writer = 1u << 31;
+
+  std::atomic<unsigned> state_{0};
+  std::mutex writers_;
 };
 
 template <class Axes, class Storage,
           class DetailMutex = mp11::mp_if_c<(Storage::has_threading_support &&
                                              detail::has_growing_axis<Axes>::value),
-                                            std::mutex, detail::null_mutex>>
+                                            growth_mutex, detail::null_mutex>>
 struct mutex_base : empty_value<DetailMutex> {
   mutex_base() = default;
   // do not copy or move mutex
@@ -0,0 +1,135 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_DETAIL_SPARSE_REFERENCE_HPP
+#define BOOST_HISTOGRAM_DETAIL_SPARSE_REFERENCE_HPP
+
+#include <boost/histogram/detail/detect.hpp>
+#include <cstddef>
+#include <iosfwd>
+#include <type_traits>
+#include <utility>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+/*
+  Proxy reference to a cell of a storage which does not keep all cells in memory.
+
+  Reading a cell which is not in memory gives T{}, writing to it puts it into memory.
+  Storage S must provide:
+  - const T& operator[](std::size_t) const, which returns T{} for absent cells
+  - T* find(std::size_t), which returns nullptr for absent cells
+  - T& insert(std::size_t), which puts an absent cell with value T{} into memory
+  - void erase(std::size_t), which sets the cell to T{} and may remove it from memory
+*/
+template <class S, class T>
+class sparse_reference {
+public:
+  using value_type = T;
+  using const_reference = const value_type&;
+
+  sparse_reference(S* s, std::size_t i) noexcept : s_(s), idx_(i) {}
+
+  sparse_reference(const sparse_reference&) noexcept = default;
+  sparse_reference& operator=(const sparse_reference& o) {
+    if (this != &o) operator=(static_cast<const_reference>(o));
+    return *this;
+  }
+
+  operator const_reference() const noexcept {
+    return static_cast<const S*>(s_)->operator[](idx_);
+  }
+
+  sparse_reference& operator=(const_reference u) {
+    // u may point into the storage, which insert or erase may reallocate or shift
+    const value_type x = u;
+    if (x == value_type{})
+      s_->erase(idx_);
+    else
+      s_->insert(idx_) = x;
+    return *this;
+  }
+
+  template <class U, class V = value_type,
+            class = std::enable_if_t<has_operator_radd<V, U>::value>>
+  sparse_reference& operator+=(const U& u) {
+    s_->insert(idx_) += u;
+    return *this;
+  }
+
+  template <class U, class V = value_type,
+            class = std::enable_if_t<has_operator_rsub<V, U>::value>>
+  sparse_reference& operator-=(const U& u) {
+    s_->insert(idx_) -= u;
+    return *this;
+  }
+
+  template <class U, class V = value_type,
+            class = std::enable_if_t<has_operator_rmul<V, U>::value>>
+  sparse_reference& operator*=(const U& u) {
+    if (auto p = s_->find(idx_)) *p *= u;
+    return *this;
+  }
+
+  template <class U, class V = value_type,
+            class = std::enable_if_t<has_operator_rdiv<V, U>::value>>
+  sparse_reference& operator/=(const U& u) {
+    if (auto p = s_->find(idx_))
+      *p /= u;
+    else if (!(value_type{} / u == value_type{}))
+      s_->insert(idx_) = value_type{} / u;
+    return *this;
+  }
+
+  template <class V = value_type,
+            class = std::enable_if_t<has_operator_preincrement<V>::value>>
+  sparse_reference operator++() {
+    ++s_->insert(idx_);
+    return *this;
+  }
+
+  template <class V = value_type,
+            class = std::enable_if_t<has_operator_preincrement<V>::value>>
+  value_type operator++(int) {
+    const value_type tmp = *this;
+    operator++();
+    return tmp;
+  }
+
+  template <class U, class = std::enable_if_t<has_operator_equal<value_type, U>::value>>
+  bool operator==(const U& rhs) const {
+    return operator const_reference() == rhs;
+  }
+
+  template <class U, class = std::enable_if_t<has_operator_equal<value_type, U>::value>>
+  bool operator!=(const U& rhs) const {
+    return !operator==(rhs);
+  }
+
+  template <class CharT, class Traits>
+  friend std::basic_ostream<CharT, Traits>& operator<<(
+      std::basic_ostream<CharT, Traits>& os, sparse_reference x) {
+    os << static_cast<const_reference>(x);
+    return os;
+  }
+
+  template <class... Ts>
+  auto operator()(const Ts&... args) -> decltype(std::declval<value_type>()(args...)) {
+    return s_->insert(idx_)(args...);
+  }
+
+private:
+  S* s_;
+  std::size_t idx_;
+};
+
+} // namespace detail
+} // namespace histogram
+} // namespace boost
+
+#endif
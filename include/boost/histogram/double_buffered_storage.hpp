@@ -0,0 +1,338 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_DOUBLE_BUFFERED_STORAGE_HPP
+#define BOOST_HISTOGRAM_DOUBLE_BUFFERED_STORAGE_HPP
+
+#include <atomic>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+#include <cstdint>
+#include <iosfwd>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Storage with an active and a standby buffer, which are swapped to take snapshots.
+
+  Histograms which are filled continuously, for example in a monitoring service, are
+  periodically exported and reset. Doing this with a single buffer loses or duplicates
+  the fills which happen between the copy and the reset. This storage fills the active
+  buffer, while the standby buffer is zero. swap_buffers() makes the standby buffer the
+  active one and returns the filled buffer once all fills which started before the swap
+  are done.
+
+  Each write to a cell increments a shared counter before and a counter of the written
+  buffer after the write, which tells swap_buffers() when the old buffer is complete.
+  Writers never wait, only swap_buffers() waits for the writers which are still running.
+  Batched fills enter and leave the buffer once per chunk.
+
+  Concurrent fills are safe if the buffer type has threading support. Reading cells,
+  which reads the active buffer, is not safe while swap_buffers() runs. Axes which grow
+  replace the whole storage, so they must not grow during a call to swap_buffers().
+
+  @tparam Storage type of the two buffers.
+*/
+template <class Storage>
+class double_buffered_storage {
+  static_assert(detail::is_storage<Storage>::value, "Storage must be a storage type");
+
+public:
+  static constexpr bool has_threading_support = Storage::has_threading_support;
+
+  using buffer_type = Storage;
+  using value_type = typename buffer_type::value_type;
+  using const_reference = typename buffer_type::const_reference;
+
+  /// Proxy reference to a cell, which writes to the active buffer.
+  class reference {
+  public:
+    reference(double_buffered_storage* s, std::size_t i) noexcept : s_(s), idx_(i) {}
+
+    reference(const reference&) noexcept = default;
+    reference& operator=(const reference& o) {
+      if (this != &o) {
+        const value_type x = static_cast<const_reference>(o);
+        operator=(x);
+      }
+      return *this;
+    }
+
+    operator const_reference() const noexcept {
+      return static_cast<const double_buffered_storage*>(s_)->operator[](idx_);
+    }
+
+    reference& operator=(const value_type& u) {
+      write([&u](auto&& x) { x = u; });
+      return *this;
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_radd<V, U>::value>>
+    reference& operator+=(const U& u) {
+      write([&u](auto&& x) { x += u; });
+      return *this;
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_rsub<V, U>::value>>
+    reference& operator-=(const U& u) {
+      write([&u](auto&& x) { x -= u; });
+      return *this;
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_rmul<V, U>::value>>
+    reference& operator*=(const U& u) {
+      write([&u](auto&& x) { x *= u; });
+      return *this;
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_rdiv<V, U>::value>>
+    reference& operator/=(const U& u) {
+      write([&u](auto&& x) { x /= u; });
+      return *this;
+    }
+
+    template <class V = value_type,
+              class = std::enable_if_t<detail::has_operator_preincrement<V>::value>>
+    reference& operator++() {
+      write([](auto&& x) { ++x; });
+      return *this;
+    }
+
+    template <class... Ts>
+    auto operator()(const Ts&... args)
+        -> decltype(std::declval<value_type>()(args...), void()) {
+      write([&](auto&& x) { x(args...); });
+    }
+
+    template <class U,
+              class = std::enable_if_t<detail::has_operator_equal<value_type, U>::value>>
+    bool operator==(const U& rhs) const {
+      return operator const_reference() == rhs;
+    }
+
+    template <class U,
+              class = std::enable_if_t<detail::has_operator_equal<value_type, U>::value>>
+    bool operator!=(const U& rhs) const {
+      return !operator==(rhs);
+    }
+
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os, reference x) {
+      os << static_cast<const_reference>(x);
+      return os;
+    }
+
+  private:
+    template <class F>
+    void write(F f) {
+      const auto i = idx_;
+      s_->write([i, &f](buffer_type& b) { f(b[i]); });
+    }
+
+    double_buffered_storage* s_;
+    std::size_t idx_;
+  };
+
+private:
+  template <class Value, class Reference, class StoragePtr>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, StoragePtr>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class P>
+    iterator_impl(const iterator_impl<V, R, P>& it) noexcept
+        : iterator_impl::iterator_adaptor_(it.base()), s_(it.s_) {}
+    iterator_impl(StoragePtr s, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), s_(s) {}
+
+    Reference operator*() const { return (*s_)[this->base()]; }
+
+    template <class V, class R, class P>
+    friend class iterator_impl;
+
+  private:
+    StoragePtr s_ = nullptr;
+  };
+
+public:
+  using iterator = iterator_impl<value_type, reference, double_buffered_storage*>;
+  using const_iterator = iterator_impl<const value_type, const_reference,
+                                       const double_buffered_storage*>;
+
+  double_buffered_storage() = default;
+
+  /// Use buffer as the active buffer, the standby buffer is a copy with zero cells.
+  explicit double_buffered_storage(buffer_type buffer)
+      : buffers_{std::move(buffer), buffer_type{}}, size_(buffers_[0].size()) {
+    buffers_[1] = buffers_[0];
+    buffers_[1].reset(size_);
+  }
+
+  // copies and moves are not thread-safe, they take only the active buffer
+  double_buffered_storage(const double_buffered_storage& x)
+      : double_buffered_storage(x.buffers_[x.active()]) {}
+
+  double_buffered_storage& operator=(const double_buffered_storage& x) {
+    if (this != &x) *this = double_buffered_storage(x);
+    return *this;
+  }
+
+  double_buffered_storage(double_buffered_storage&& x)
+      : buffers_{std::move(x.buffers_[x.active()]),
+                 std::move(x.buffers_[1 - x.active()])}
+      , size_(x.size_) {}
+
+  double_buffered_storage& operator=(double_buffered_storage&& x) {
+    if (this != &x) {
+      const auto k = x.active();
+      buffers_[0] = std::move(x.buffers_[k]);
+      buffers_[1] = std::move(x.buffers_[1 - k]);
+      size_ = x.size_;
+      start_.store(0, std::memory_order_relaxed);
+      end_[0].store(0, std::memory_order_relaxed);
+      end_[1].store(0, std::memory_order_relaxed);
+    }
+    return *this;
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit double_buffered_storage(const Iterable& s)
+      : double_buffered_storage(buffer_type(s)) {}
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  double_buffered_storage& operator=(const Iterable& s) {
+    *this = double_buffered_storage(s);
+    return *this;
+  }
+
+  /// Reset both buffers, not thread-safe.
+  void reset(std::size_t n) {
+    buffers_[0].reset(n);
+    buffers_[1].reset(n);
+    size_ = n;
+  }
+
+  // does not touch the buffers, which swap_buffers() replaces while fills are running
+  std::size_t size() const noexcept { return size_; }
+
+  reference operator[](std::size_t i) noexcept { return {this, i}; }
+
+  /// Return cell of the active buffer.
+  const_reference operator[](std::size_t i) const noexcept {
+    return buffers_[active()][i];
+  }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size()}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size()}; }
+
+  /// Return the active buffer.
+  const buffer_type& active_buffer() const noexcept { return buffers_[active()]; }
+
+  bool operator==(const double_buffered_storage& x) const noexcept {
+    return active_buffer() == x.active_buffer();
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    return active_buffer() == iterable;
+  }
+
+  /**
+    Make the standby buffer the active one and return the previously active buffer.
+
+    Fills which start after the swap go into the new active buffer. The call waits until
+    fills which started before the swap are done, so that the returned buffer is
+    complete. The cells of the returned buffer are replaced by a buffer of zero cells,
+    which becomes the standby buffer. Several threads may call this concurrently.
+  */
+  buffer_type swap_buffers() {
+    std::lock_guard<std::mutex> guard(swap_mutex_);
+    const unsigned k = active();
+    // writers of the other buffer from the previous period are all done
+    end_[1 - k].store(0, std::memory_order_relaxed);
+    const auto started =
+        start_.exchange(k ? 0 : phase_bit, std::memory_order_acq_rel) & ~phase_bit;
+    while (end_[k].load(std::memory_order_acquire) != started)
+      std::this_thread::yield();
+    buffer_type result = std::move(buffers_[k]);
+    // copy keeps the allocator and other settings of the buffer
+    buffers_[k] = result;
+    buffers_[k].reset(result.size());
+    return result;
+  }
+
+  /// implementation detail; used by fill_n, runs f on the active buffer
+  template <class F>
+  void write(F&& f) {
+    // number of started writes, its highest bit is the index of the active buffer
+    const auto s = start_.fetch_add(1, std::memory_order_acquire);
+    const unsigned k = s & phase_bit ? 1 : 0;
+    f(buffers_[k]);
+    end_[k].fetch_add(1, std::memory_order_release);
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    const auto k = active();
+    ar& make_nvp("buffer", buffers_[k]);
+    if (Archive::is_loading::value) {
+      size_ = buffers_[k].size();
+      buffers_[1 - k].reset(size_);
+    }
+  }
+
+private:
+  static constexpr std::uint64_t phase_bit = std::uint64_t(1) << 63;
+
+  unsigned active() const noexcept {
+    return start_.load(std::memory_order_acquire) & phase_bit ? 1 : 0;
+  }
+
+  buffer_type buffers_[2];
+  std::size_t size_ = 0;
+  std::atomic<std::uint64_t> start_{0};
+  std::atomic<std::uint64_t> end_[2] = {{0}, {0}};
+  std::mutex swap_mutex_;
+};
+
+/**
+  Return the cells which were filled since the last call and continue with zero cells.
+
+  The returned histogram has copies of the axes of h and the previously active buffer of
+  its storage. See double_buffered_storage::swap_buffers() for the guarantees.
+
+  @param h histogram with double_buffered_storage.
+*/
+template <class Axes, class Storage>
+histogram<Axes, Storage> swap_buffers(
+    histogram<Axes, double_buffered_storage<Storage>>& h) {
+  histogram<Axes, Storage> result(unsafe_access::axes(h), Storage());
+  unsafe_access::storage(result) = unsafe_access::storage(h).swap_buffers();
+  return result;
+}
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,39 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_FILL_TUNING_HPP
+#define BOOST_HISTOGRAM_FILL_TUNING_HPP
+
+#include <cstddef>
+
+namespace boost {
+namespace histogram {
+
+/** Tuning parameters for filling a histogram with several values at once.
+
+  When histogram::fill is called with iterables, the indices of a batch of values are
+  computed first and then the corresponding storage cells are filled. The parameters
+  control the size of the batch and how far ahead storage cells are prefetched while
+  the cells are filled. They only affect the performance, not the result.
+
+  Use histogram::tuning to change the parameters of a histogram.
+*/
+struct fill_tuning {
+  /// Number of indices which are computed in one batch, must be positive.
+  std::size_t buffer_size = 1ul << 14;
+
+  /** Prefetch distance in the batch of indices, zero disables prefetching.
+
+    Prefetching only helps if the storage is too large for the CPU cache, it is
+    therefore only done for large storages with contiguous cells.
+  */
+  std::size_t prefetch_distance = 16;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
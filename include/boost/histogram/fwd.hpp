@@ -14,6 +14,8 @@
 
 #include <boost/config.hpp> // BOOST_ATTRIBUTE_NODISCARD
 #include <boost/core/use_default.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace boost {
@@ -101,6 +103,12 @@ class mean;
 template <class ValueType = double>
 class weighted_mean;
 
+template <class ValueType = double, std::size_t Replicas = 100>
+class bootstrap;
+
+template <class ValueType = double>
+class quantile_sketch;
+
 template <class T>
 class thread_safe;
 
@@ -116,9 +124,36 @@ struct unsafe_access;
 template <class Allocator = std::allocator<char>>
 class unlimited_storage;
 
+template <class Allocator = std::allocator<char>, std::size_t BlockSize = 4096>
+class blocked_unlimited_storage;
+
 template <class T>
 class storage_adaptor;
 
+template <class T = double, class Allocator = std::allocator<T>>
+class sparse_storage;
+
+template <class T = double, std::size_t PageSize = 1024,
+          class Allocator = std::allocator<T>>
+class paged_storage;
+
+template <class T = double>
+class mapped_storage;
+
+template <class T = std::uint64_t, std::size_t Shards = 8,
+          class Allocator = std::allocator<T>>
+class sharded_storage;
+
+template <class Storage>
+class double_buffered_storage;
+
+template <class Accumulator,
+          class Allocator = std::allocator<typename Accumulator::value_type>>
+class soa_storage;
+
+template <class T = double, class Allocator = std::allocator<T>>
+class quantile_storage;
+
 #endif // BOOST_HISTOGRAM_DOXYGEN_INVOKED
 
 /// Vector-like storage for fast zero-overhead access to cells.
@@ -137,6 +172,9 @@ using profile_storage = dense_storage<accumulators::mean<>>;
 /// Dense storage which tracks means of weighted samples in each cell.
 using weighted_profile_storage = dense_storage<accumulators::weighted_mean<>>;
 
+/// Dense storage which tracks Poisson bootstrap replicas of the sum of weights.
+using bootstrap_storage = dense_storage<accumulators::bootstrap<>>;
+
 // some forward declarations must be hidden from doxygen to fix the reference docu :(
 #ifndef BOOST_HISTOGRAM_DOXYGEN_INVOKED
 
@@ -17,9 +17,13 @@
 #include <boost/histogram/detail/mutex_base.hpp>
 #include <boost/histogram/detail/non_member_container_access.hpp>
 #include <boost/histogram/detail/span.hpp>
+#include <boost/histogram/fill_tuning.hpp>
 #include <boost/histogram/fwd.hpp>
 #include <boost/histogram/sample.hpp>
+#include <boost/histogram/selection.hpp>
 #include <boost/histogram/storage_adaptor.hpp>
+#include <boost/histogram/strided.hpp>
+#include <boost/histogram/threads.hpp>
 #include <boost/histogram/unsafe_access.hpp>
 #include <boost/histogram/weight.hpp>
 #include <boost/mp11/integral.hpp>
@@ -77,14 +81,17 @@ public:
   template <class A, class S>
   explicit histogram(histogram<A, S>&& rhs)
       : storage_(std::move(unsafe_access::storage(rhs)))
-      , offset_(unsafe_access::offset(rhs)) {
+      , offset_(unsafe_access::offset(rhs))
+      , tuning_(rhs.tuning()) {
     detail::axes_assign(axes_, std::move(unsafe_access::axes(rhs)));
     detail::throw_if_axes_is_too_large(axes_);
   }
 
   template <class A, class S>
   explicit histogram(const histogram<A, S>& rhs)
-      : storage_(unsafe_access::storage(rhs)), offset_(unsafe_access::offset(rhs)) {
+      : storage_(unsafe_access::storage(rhs))
+      , offset_(unsafe_access::offset(rhs))
+      , tuning_(rhs.tuning()) {
     detail::axes_assign(axes_, unsafe_access::axes(rhs));
     detail::throw_if_axes_is_too_large(axes_);
   }
@@ -95,6 +102,7 @@ public:
     detail::throw_if_axes_is_too_large(axes_);
     storage_ = std::move(unsafe_access::storage(rhs));
     offset_ = unsafe_access::offset(rhs);
+    tuning_ = rhs.tuning();
     return *this;
   }
 
@@ -104,6 +112,7 @@ public:
     detail::throw_if_axes_is_too_large(axes_);
     storage_ = unsafe_access::storage(rhs);
     offset_ = unsafe_access::offset(rhs);
+    tuning_ = rhs.tuning();
     return *this;
   }
 
@@ -153,6 +162,21 @@ public:
     return detail::for_each_axis(axes_, std::forward<Unary>(unary));
   }
 
+  /// Return tuning parameters for filling with several values at once.
+  const fill_tuning& tuning() const noexcept { return tuning_; }
+
+  /** Set tuning parameters for filling with several values at once.
+
+    Passing a buffer size of zero causes a throw of `std::invalid_argument`.
+
+    @param t tuning parameters, see fill_tuning.
+  */
+  void tuning(const fill_tuning& t) {
+    if (t.buffer_size == 0)
+      BOOST_THROW_EXCEPTION(std::invalid_argument("buffer size must be positive"));
+    tuning_ = t;
+  }
+
   /** Fill histogram with values, an optional weight, and/or a sample.
 
     Arguments are passed in order to the axis objects. Passing an argument type that is
@@ -199,9 +223,8 @@ public:
                                            typename acc_traits::args>();
     constexpr bool sample_valid =
         std::is_convertible<typename arg_traits::sargs, typename acc_traits::args>::value;
-    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
     return detail::fill(mp11::mp_bool<(weight_valid && sample_valid)>{}, arg_traits{},
-                        offset_, storage_, axes_, args);
+                        offset_, storage_, axes_, args, mutex_base::get());
   }
 
   /** Fill histogram with several values at once.
@@ -227,8 +250,9 @@ public:
     static_assert(n_sample_args_expected == 0,
                   "sample argument is missing but required by accumulator");
     std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
-    detail::fill_n(mp11::mp_bool<(n_sample_args_expected == 0)>{}, offset_, storage_,
-                   axes_, detail::make_span(args));
+    detail::fill_n(mp11::mp_bool<(n_sample_args_expected == 0)>{}, 1, tuning_,
+                   detail::no_selection{}, offset_, storage_, axes_,
+                   detail::make_span(args));
   }
 
   /** Fill histogram with several values and weights at once.
@@ -245,9 +269,9 @@ public:
     constexpr bool sample_valid =
         std::is_convertible<std::tuple<>, typename acc_traits::args>::value;
     std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
-    detail::fill_n(mp11::mp_bool<(weight_valid && sample_valid)>{}, offset_, storage_,
-                   axes_, detail::make_span(args),
-                   weight(detail::to_ptr_size(weights.value)));
+    detail::fill_n(mp11::mp_bool<(weight_valid && sample_valid)>{}, 1, tuning_,
+                   detail::no_selection{}, offset_, storage_, axes_,
+                   detail::make_span(args), weight(detail::to_ptr_size(weights.value)));
   }
 
   /** Fill histogram with several values and weights at once.
@@ -277,7 +301,8 @@ public:
         [&](const auto&... sargs) {
           constexpr bool sample_valid =
               std::is_convertible<sample_args_passed, typename acc_traits::args>::value;
-          detail::fill_n(mp11::mp_bool<(sample_valid)>{}, offset_, storage_, axes_,
+          detail::fill_n(mp11::mp_bool<(sample_valid)>{}, 1, tuning_,
+                         detail::no_selection{}, offset_, storage_, axes_,
                          detail::make_span(args), detail::to_ptr_size(sargs)...);
         },
         samples.value);
@@ -309,8 +334,9 @@ public:
           static_assert(weight_valid, "error: accumulator does not support weights");
           constexpr bool sample_valid =
               std::is_convertible<sample_args_passed, typename acc_traits::args>::value;
-          detail::fill_n(mp11::mp_bool<(weight_valid && sample_valid)>{}, offset_,
-                         storage_, axes_, detail::make_span(args),
+          detail::fill_n(mp11::mp_bool<(weight_valid && sample_valid)>{}, 1, tuning_,
+                         detail::no_selection{}, offset_, storage_, axes_,
+                         detail::make_span(args),
                          weight(detail::to_ptr_size(weights.value)),
                          detail::to_ptr_size(sargs)...);
         },
@@ -335,6 +361,148 @@ public:
     fill(args, weights, samples);
   }
 
+  /** Fill histogram with several values at once, using several threads.
+
+    Works like fill(args), but the work is split among the requested number of threads.
+    The storage cells are partitioned into disjunct sets, each thread fills one set, so
+    the cells do not need to be thread-safe. The result is identical to the result of the
+    serial fill. If a cell cannot be written independently from other cells (e.g. when
+    the unlimited_storage is used) or if any axis is growing, the serial fill is used.
+
+    @param args iterable as explained in the long description of fill(args).
+    @param t number of threads, see threads().
+  */
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  void fill(const Iterable& args, const threads_type& t) {
+    using acc_traits = detail::accumulator_traits<value_type>;
+    constexpr unsigned n_sample_args_expected =
+        std::tuple_size<typename acc_traits::args>::value;
+    static_assert(n_sample_args_expected == 0,
+                  "sample argument is missing but required by accumulator");
+    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
+    detail::fill_n(mp11::mp_bool<(n_sample_args_expected == 0)>{}, detail::nthreads(t),
+                   tuning_, detail::no_selection{}, offset_, storage_, axes_,
+                   detail::make_span(args));
+  }
+
+  /** Fill histogram with several values and weights at once, using several threads.
+
+    @param args iterable of values.
+    @param weights single weight or an iterable of weights.
+    @param t number of threads, see threads().
+  */
+  template <class Iterable, class T, class = detail::requires_iterable<Iterable>>
+  void fill(const Iterable& args, const weight_type<T>& weights, const threads_type& t) {
+    using acc_traits = detail::accumulator_traits<value_type>;
+    constexpr bool weight_valid = acc_traits::wsupport::value;
+    static_assert(weight_valid, "error: accumulator does not support weights");
+    detail::sample_args_passed_vs_expected<std::tuple<>, typename acc_traits::args>();
+    constexpr bool sample_valid =
+        std::is_convertible<std::tuple<>, typename acc_traits::args>::value;
+    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
+    detail::fill_n(mp11::mp_bool<(weight_valid && sample_valid)>{}, detail::nthreads(t),
+                   tuning_, detail::no_selection{}, offset_, storage_, axes_,
+                   detail::make_span(args), weight(detail::to_ptr_size(weights.value)));
+  }
+
+  /** Fill histogram with several values and samples at once, using several threads.
+
+    @param args iterable of values.
+    @param samples single sample or an iterable of samples.
+    @param t number of threads, see threads().
+  */
+  template <class Iterable, class... Ts, class = detail::requires_iterable<Iterable>>
+  void fill(const Iterable& args, const sample_type<std::tuple<Ts...>>& samples,
+            const threads_type& t) {
+    using acc_traits = detail::accumulator_traits<value_type>;
+    using sample_args_passed =
+        std::tuple<decltype(*detail::to_ptr_size(std::declval<Ts>()).first)...>;
+    detail::sample_args_passed_vs_expected<sample_args_passed,
+                                           typename acc_traits::args>();
+    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
+    mp11::tuple_apply(
+        [&](const auto&... sargs) {
+          constexpr bool sample_valid =
+              std::is_convertible<sample_args_passed, typename acc_traits::args>::value;
+          detail::fill_n(mp11::mp_bool<(sample_valid)>{}, detail::nthreads(t), tuning_,
+                         detail::no_selection{}, offset_, storage_, axes_,
+                         detail::make_span(args), detail::to_ptr_size(sargs)...);
+        },
+        samples.value);
+  }
+
+  /** Fill histogram with the selected rows of several values at once.
+
+    Works like fill(args), but only the rows selected by a mask or by a sequence of row
+    numbers are filled, without copying the values. Indices are only computed for the
+    selected rows.
+
+    @param args iterable as explained in the long description of fill(args).
+    @param sel row selection, see mask() and rows().
+  */
+  template <class Iterable, class Selection, class = detail::requires_iterable<Iterable>,
+            class = detail::requires_selection<Selection>>
+  void fill(const Iterable& args, const Selection& sel) {
+    using acc_traits = detail::accumulator_traits<value_type>;
+    constexpr unsigned n_sample_args_expected =
+        std::tuple_size<typename acc_traits::args>::value;
+    static_assert(n_sample_args_expected == 0,
+                  "sample argument is missing but required by accumulator");
+    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
+    detail::fill_n(mp11::mp_bool<(n_sample_args_expected == 0)>{}, 1, tuning_, sel,
+                   offset_, storage_, axes_, detail::make_span(args));
+  }
+
+  /** Fill histogram with the selected rows of several values and weights at once.
+
+    @param args iterable of values.
+    @param weights single weight or an iterable of weights.
+    @param sel row selection, see mask() and rows().
+  */
+  template <class Iterable, class T, class Selection,
+            class = detail::requires_iterable<Iterable>,
+            class = detail::requires_selection<Selection>>
+  void fill(const Iterable& args, const weight_type<T>& weights, const Selection& sel) {
+    using acc_traits = detail::accumulator_traits<value_type>;
+    constexpr bool weight_valid = acc_traits::wsupport::value;
+    static_assert(weight_valid, "error: accumulator does not support weights");
+    detail::sample_args_passed_vs_expected<std::tuple<>, typename acc_traits::args>();
+    constexpr bool sample_valid =
+        std::is_convertible<std::tuple<>, typename acc_traits::args>::value;
+    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
+    detail::fill_n(mp11::mp_bool<(weight_valid && sample_valid)>{}, 1, tuning_, sel,
+                   offset_, storage_, axes_, detail::make_span(args),
+                   weight(detail::to_ptr_size(weights.value)));
+  }
+
+  /** Fill histogram with the selected rows of several values and samples at once.
+
+    @param args iterable of values.
+    @param samples single sample or an iterable of samples.
+    @param sel row selection, see mask() and rows().
+  */
+  template <class Iterable, class... Ts, class Selection,
+            class = detail::requires_iterable<Iterable>,
+            class = detail::requires_selection<Selection>>
+  void fill(const Iterable& args, const sample_type<std::tuple<Ts...>>& samples,
+            const Selection& sel) {
+    using acc_traits = detail::accumulator_traits<value_type>;
+    using sample_args_passed =
+        std::tuple<decltype(*detail::to_ptr_size(std::declval<Ts>()).first)...>;
+    detail::sample_args_passed_vs_expected<sample_args_passed,
+                                           typename acc_traits::args>();
+    std::lock_guard<typename mutex_base::type> guard{mutex_base::get()};
+    mp11::tuple_apply(
+        [&](const auto&... sargs) {
+          constexpr bool sample_valid =
+              std::is_convertible<sample_args_passed, typename acc_traits::args>::value;
+          detail::fill_n(mp11::mp_bool<(sample_valid)>{}, 1, tuning_, sel, offset_,
+                         storage_, axes_, detail::make_span(args),
+                         detail::to_ptr_size(sargs)...);
+        },
+        samples.value);
+  }
+
   /** Access cell value at integral indices.
 
     You can pass indices as individual arguments, as a std::tuple of integers, or as an
@@ -444,8 +612,14 @@ public:
   operator+=(const histogram<A, S>& rhs) {
     if (!detail::axes_equal(axes_, unsafe_access::axes(rhs)))
       BOOST_THROW_EXCEPTION(std::invalid_argument("axes of histograms differ"));
-    auto rit = unsafe_access::storage(rhs).begin();
-    for (auto&& x : storage_) x += *rit++;
+    // use special implementation of addition if available
+    detail::static_if<detail::has_operator_radd<storage_type, const S&>>(
+        [](auto& s, const auto& rs) { s += rs; },
+        [](auto& s, const auto& rs) {
+          auto rit = rs.begin();
+          for (auto&& x : s) x += *rit++;
+        },
+        storage_, unsafe_access::storage(rhs));
     return *this;
   }
 
@@ -549,6 +723,7 @@ private:
   axes_type axes_;
   storage_type storage_;
   std::size_t offset_ = 0;
+  fill_tuning tuning_;
 
   friend struct unsafe_access;
 };
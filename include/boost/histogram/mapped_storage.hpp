@@ -0,0 +1,225 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_MAPPED_STORAGE_HPP
+#define BOOST_HISTOGRAM_MAPPED_STORAGE_HPP
+
+/**
+  \file boost/histogram/mapped_storage.hpp
+
+  Storage which keeps the cells in a memory-mapped file. This header is not included by
+  boost/histogram.hpp, because it depends on
+  [Boost.Interprocess](https://www.boost.org/doc/libs/develop/doc/html/interprocess.html).
+*/
+
+#include <algorithm>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/detail/array_wrapper.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <boost/interprocess/anonymous_shared_memory.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/throw_exception.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Dense storage which keeps the cells in a memory-mapped file.
+
+  The cells are the raw bytes of the file, which is mapped into memory with
+  Boost.Interprocess. The operating system loads and writes back the pages of the file
+  on demand, so a histogram can be larger than the available memory. A histogram with
+  this storage can be reopened later without deserialization, by constructing it with
+  the same axes and a storage which opens the existing file.
+
+  A newly created file is filled with zero bytes, which must represent `value_type{}`.
+  This is true for the builtin arithmetic types and the accumulators of this library.
+  The file contains the cells in native byte order, it is not portable between
+  platforms.
+
+  A default-constructed storage and copies of a storage keep their cells in anonymous
+  memory which is not backed by a file. Axes which grow are not supported with a
+  file-backed storage, because growing replaces the storage with a new one.
+
+  @tparam T value type of the cells, must be trivially copyable.
+*/
+template <class T>
+class mapped_storage {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "value_type of mapped_storage must be trivially copyable");
+
+public:
+  static constexpr bool has_threading_support = false;
+
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+
+  /// How the file is treated on the first call to reset().
+  enum class file_mode {
+    /// Create the file or truncate an existing file, all cells are zero.
+    create,
+    /// Map an existing file of matching size and keep its cells.
+    open
+  };
+
+  /// Storage in anonymous memory.
+  mapped_storage() = default;
+
+  /// Storage backed by the file at path, which is mapped on the first call to reset().
+  explicit mapped_storage(std::string path, file_mode mode = file_mode::create)
+      : path_(std::move(path)), mode_(mode) {}
+
+  mapped_storage(const mapped_storage& x) : mapped_storage() {
+    reset(x.size_);
+    std::copy(x.begin(), x.end(), begin());
+  }
+
+  mapped_storage& operator=(const mapped_storage& x) {
+    if (this != &x) *this = mapped_storage(x);
+    return *this;
+  }
+
+  mapped_storage(mapped_storage&& x) noexcept { swap(x); }
+
+  mapped_storage& operator=(mapped_storage&& x) noexcept {
+    swap(x);
+    return *this;
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit mapped_storage(const Iterable& s) : mapped_storage() {
+    using std::begin;
+    using std::end;
+    reset(static_cast<std::size_t>(std::distance(begin(s), end(s))));
+    std::copy(begin(s), end(s), this->begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  mapped_storage& operator=(const Iterable& s) {
+    *this = mapped_storage(s);
+    return *this;
+  }
+
+  /**
+    Map n cells.
+
+    On the first call, an existing file is kept if the storage was constructed with
+    file_mode::open, otherwise the file is created or truncated. All later calls set the
+    cells to zero.
+
+    @throws std::invalid_argument if an existing file does not have the size of n cells.
+  */
+  void reset(std::size_t n) {
+    namespace ip = boost::interprocess;
+    const std::size_t bytes = n * sizeof(value_type);
+    region_ = ip::mapped_region();
+    if (path_.empty()) {
+      // mapping of size zero is not allowed
+      if (bytes > 0) region_ = ip::anonymous_shared_memory(bytes);
+    } else {
+      if (mode_ == file_mode::open) {
+        if (file_size() != bytes)
+          BOOST_THROW_EXCEPTION(
+              std::invalid_argument("size of existing file does not match storage"));
+      } else {
+        std::ofstream f(path_, std::ios::binary | std::ios::trunc);
+        // extend the file without writing all zero bytes
+        if (bytes > 0) f.seekp(static_cast<std::streamoff>(bytes - 1)).put('\0');
+        if (!f) BOOST_THROW_EXCEPTION(std::invalid_argument("cannot create file"));
+      }
+      if (bytes > 0)
+        region_ = ip::mapped_region(ip::file_mapping(path_.c_str(), ip::read_write),
+                                    ip::read_write, 0, bytes);
+      // the existing file is kept until it was mapped successfully
+      mode_ = file_mode::create;
+    }
+    size_ = n;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  reference operator[](std::size_t i) noexcept { return data()[i]; }
+  const_reference operator[](std::size_t i) const noexcept { return data()[i]; }
+
+  value_type* data() noexcept { return static_cast<value_type*>(region_.get_address()); }
+  const value_type* data() const noexcept {
+    return static_cast<const value_type*>(region_.get_address());
+  }
+
+  iterator begin() noexcept { return data(); }
+  iterator end() noexcept { return data() + size_; }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator end() const noexcept { return data() + size_; }
+
+  /// Path of the file, empty if the cells are in anonymous memory.
+  const std::string& path() const noexcept { return path_; }
+
+  /// Write modified cells back to the file and wait until this is done.
+  void flush() {
+    if (size_ > 0) region_.flush();
+  }
+
+  bool operator==(const mapped_storage& x) const noexcept {
+    return size_ == x.size_ && std::equal(begin(), end(), x.begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    if (size_ != static_cast<std::size_t>(iterable.size())) return false;
+    return std::equal(begin(), end(), std::begin(iterable));
+  }
+
+  template <class V = value_type,
+            class = std::enable_if_t<detail::has_operator_rmul<V, double>::value>>
+  mapped_storage& operator*=(const double x) {
+    for (auto&& c : *this) c *= x;
+    return *this;
+  }
+
+  void swap(mapped_storage& x) noexcept {
+    using std::swap;
+    region_.swap(x.region_);
+    swap(path_, x.path_);
+    swap(mode_, x.mode_);
+    swap(size_, x.size_);
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    std::size_t size = size_;
+    ar& make_nvp("size", size);
+    if (Archive::is_loading::value) reset(size);
+    auto w = detail::make_array_wrapper(data(), size_);
+    ar& make_nvp("array", w);
+  }
+
+private:
+  std::size_t file_size() const {
+    std::ifstream f(path_, std::ios::binary | std::ios::ate);
+    if (!f) BOOST_THROW_EXCEPTION(std::invalid_argument("cannot open file"));
+    return static_cast<std::size_t>(f.tellg());
+  }
+
+  boost::interprocess::mapped_region region_;
+  std::string path_;
+  file_mode mode_ = file_mode::create;
+  std::size_t size_ = 0;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
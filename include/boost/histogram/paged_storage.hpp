@@ -0,0 +1,279 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_PAGED_STORAGE_HPP
+#define BOOST_HISTOGRAM_PAGED_STORAGE_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/core/exchange.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/detail/array_wrapper.hpp>
+#include <boost/histogram/detail/buffer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/detail/optional_index.hpp>
+#include <boost/histogram/detail/sparse_reference.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Dense storage which allocates memory for pages of cells on first write.
+
+  The cells are split into pages of fixed size. A page is allocated when one of its
+  cells is written to, cells in pages which are not allocated read as `value_type{}`.
+  This saves memory for histograms where the filled cells are clustered, while the
+  lookup of a cell remains a shift and a load, unlike in a hash-based sparse storage.
+
+  @tparam T value type of the cells.
+  @tparam PageSize number of cells per page, must be a power of two.
+  @tparam Allocator allocator for the pages.
+*/
+template <class T, std::size_t PageSize, class Allocator>
+class paged_storage {
+  static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0,
+                "PageSize must be a power of two");
+
+public:
+  static constexpr bool has_threading_support = false;
+  static constexpr std::size_t page_size = PageSize;
+
+  using value_type = T;
+  using allocator_type = Allocator;
+  using const_reference = const value_type&;
+  using reference = detail::sparse_reference<paged_storage, value_type>;
+
+private:
+  using pointer = typename std::allocator_traits<allocator_type>::pointer;
+  using page_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<pointer>;
+  using pages_type = std::vector<pointer, page_allocator_type>;
+
+  template <class Value, class Reference, class StoragePtr>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, StoragePtr>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class P>
+    iterator_impl(const iterator_impl<V, R, P>& it) noexcept
+        : iterator_impl::iterator_adaptor_(it.base()), s_(it.s_) {}
+    iterator_impl(StoragePtr s, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), s_(s) {}
+
+    Reference operator*() const { return (*s_)[this->base()]; }
+
+    template <class V, class R, class P>
+    friend class iterator_impl;
+
+  private:
+    StoragePtr s_ = nullptr;
+  };
+
+public:
+  using iterator = iterator_impl<value_type, reference, paged_storage*>;
+  using const_iterator =
+      iterator_impl<const value_type, const_reference, const paged_storage*>;
+
+  explicit paged_storage(const allocator_type& a = {})
+      : alloc_(a), pages_(page_allocator_type(a)) {}
+
+  // delegating constructor, so that the destructor frees the pages if a copy throws
+  paged_storage(const paged_storage& x) : paged_storage(x.alloc_) {
+    pages_.assign(x.pages_.size(), nullptr);
+    size_ = x.size_;
+    for (std::size_t i = 0; i < pages_.size(); ++i)
+      if (x.pages_[i]) pages_[i] = detail::buffer_create(alloc_, PageSize, x.pages_[i]);
+  }
+
+  paged_storage& operator=(const paged_storage& x) {
+    if (this != &x) *this = paged_storage(x);
+    return *this;
+  }
+
+  paged_storage(paged_storage&& x) noexcept
+      : alloc_(std::move(x.alloc_))
+      , pages_(std::move(x.pages_))
+      , size_(boost::exchange(x.size_, 0)) {
+    x.pages_.clear();
+  }
+
+  paged_storage& operator=(paged_storage&& x) noexcept {
+    using std::swap;
+    swap(alloc_, x.alloc_);
+    swap(pages_, x.pages_);
+    swap(size_, x.size_);
+    return *this;
+  }
+
+  ~paged_storage() noexcept { destroy(); }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit paged_storage(const Iterable& s, const allocator_type& a = {})
+      : paged_storage(a) {
+    using std::begin;
+    using std::end;
+    reset(static_cast<std::size_t>(std::distance(begin(s), end(s))));
+    std::copy(begin(s), end(s), this->begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  paged_storage& operator=(const Iterable& s) {
+    *this = paged_storage(s, alloc_);
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return alloc_; }
+
+  void reset(std::size_t n) {
+    destroy();
+    pages_.assign((n + PageSize - 1) / PageSize, nullptr);
+    size_ = n;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  reference operator[](std::size_t i) noexcept { return {this, i}; }
+
+  const_reference operator[](std::size_t i) const noexcept {
+    static const value_type null = value_type{};
+    auto p = find(i);
+    return p ? *p : null;
+  }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+
+  /// Number of pages.
+  std::size_t pages() const noexcept { return pages_.size(); }
+
+  /// Return pointer to the cells of page i, or nullptr if it is not allocated.
+  const value_type* page(std::size_t i) const noexcept {
+    BOOST_ASSERT(i < pages_.size());
+    return pages_[i];
+  }
+
+  /// Number of allocated pages.
+  std::size_t allocated_pages() const noexcept {
+    return static_cast<std::size_t>(
+        std::count_if(pages_.begin(), pages_.end(), [](pointer p) { return p != nullptr; }));
+  }
+
+  bool operator==(const paged_storage& x) const {
+    if (size_ != x.size_) return false;
+    for (std::size_t i = 0; i < pages_.size(); ++i) {
+      const auto p = pages_[i], xp = x.pages_[i];
+      if (p == nullptr && xp == nullptr) continue;
+      const value_type null = value_type{};
+      for (std::size_t k = 0; k < PageSize; ++k)
+        if (!((p ? p[k] : null) == (xp ? xp[k] : null))) return false;
+    }
+    return true;
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    if (size_ != static_cast<std::size_t>(iterable.size())) return false;
+    auto it = std::begin(iterable);
+    for (auto&& x : *this)
+      if (!(x == *it++)) return false;
+    return true;
+  }
+
+  template <class V = value_type,
+            class = std::enable_if_t<detail::has_operator_rmul<V, double>::value>>
+  paged_storage& operator*=(const double x) {
+    for (auto&& p : pages_)
+      if (p)
+        for (auto it = p, end = p + PageSize; it != end; ++it) *it *= x;
+    return *this;
+  }
+
+  /// Add cells of another storage of same size, visits only its allocated pages.
+  template <class V = value_type,
+            class = std::enable_if_t<detail::has_operator_radd<V, V>::value>>
+  paged_storage& operator+=(const paged_storage& x) {
+    BOOST_ASSERT(size_ == x.size_);
+    for (std::size_t i = 0; i < pages_.size(); ++i) {
+      const auto xp = x.pages_[i];
+      if (xp == nullptr) continue;
+      const auto p = allocate(i);
+      for (std::size_t k = 0; k < PageSize; ++k) p[k] += xp[k];
+    }
+    return *this;
+  }
+
+  /// implementation detail; used by fill_n, increments the cells at valid indices
+  template <class Index>
+  void increment_n(const Index* indices, std::size_t n) {
+    for (auto end = indices + n; indices != end; ++indices)
+      if (detail::is_valid(*indices)) ++insert(static_cast<std::size_t>(*indices));
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    std::size_t size = size_;
+    ar& make_nvp("size", size);
+    if (Archive::is_loading::value) reset(size);
+    for (std::size_t i = 0; i < pages_.size(); ++i) {
+      bool allocated = pages_[i] != nullptr;
+      ar& make_nvp("allocated", allocated);
+      if (!allocated) continue;
+      auto w = detail::make_array_wrapper(allocate(i), PageSize);
+      ar& make_nvp("page", w);
+    }
+  }
+
+private:
+  friend reference;
+
+  const value_type* find(std::size_t i) const noexcept {
+    BOOST_ASSERT(i < size_);
+    const auto p = pages_[i / PageSize];
+    return p ? p + i % PageSize : nullptr;
+  }
+
+  value_type* find(std::size_t i) noexcept {
+    return const_cast<value_type*>(static_cast<const paged_storage*>(this)->find(i));
+  }
+
+  value_type& insert(std::size_t i) {
+    BOOST_ASSERT(i < size_);
+    return allocate(i / PageSize)[i % PageSize];
+  }
+
+  void erase(std::size_t i) noexcept {
+    if (auto p = find(i)) *p = value_type{};
+  }
+
+  pointer allocate(std::size_t page) {
+    auto& p = pages_[page];
+    if (p == nullptr) p = static_cast<pointer>(detail::buffer_create(alloc_, PageSize));
+    return p;
+  }
+
+  void destroy() noexcept {
+    for (auto&& p : pages_)
+      if (p) detail::buffer_destroy(alloc_, boost::exchange(p, nullptr), PageSize);
+  }
+
+  allocator_type alloc_;
+  pages_type pages_;
+  std::size_t size_ = 0;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,371 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_QUANTILE_STORAGE_HPP
+#define BOOST_HISTOGRAM_QUANTILE_STORAGE_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/accumulators/quantile_sketch.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <iosfwd>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Storage of quantile sketches whose centroids come from a shared pool of blocks.
+
+  A vector of quantile_sketch accumulators allocates memory for the centroids of each
+  cell separately, which is slow and fragments the memory for histograms with many
+  cells. This storage keeps the centroids of all cells in blocks of 16 centroids, which
+  are taken from a pool owned by the storage. Blocks which are no longer needed after a
+  cell is compressed go back to the pool. The pool grows like a vector, so filling the
+  histogram allocates memory only a few times.
+
+  The cells behave like quantile_sketch accumulators. Reading a cell returns a copy of
+  the sketch. A histogram with this storage can be added to another histogram with a
+  quantile_storage, which merges the sketches in each cell.
+
+  @tparam T value type of the samples.
+  @tparam Allocator allocator for the pool and the cells.
+*/
+template <class T, class Allocator>
+class quantile_storage {
+public:
+  static constexpr bool has_threading_support = false;
+
+  using value_type = accumulators::quantile_sketch<T>;
+  using element_type = T;
+  using allocator_type = Allocator;
+  using const_reference = value_type;
+
+  /// Proxy reference to a cell, which writes into the pool.
+  class reference {
+  public:
+    reference(quantile_storage* s, std::size_t i) noexcept : s_(s), idx_(i) {}
+
+    reference(const reference&) noexcept = default;
+    reference& operator=(const reference& o) {
+      return operator=(static_cast<value_type>(o));
+    }
+
+    operator value_type() const {
+      return static_cast<const quantile_storage*>(s_)->operator[](idx_);
+    }
+
+    reference& operator=(const value_type& x) {
+      s_->store(idx_, x);
+      return *this;
+    }
+
+    /// Insert sample x.
+    void operator()(const element_type& x) { s_->add(idx_, x, 1); }
+
+    /// Insert sample x with weight w.
+    void operator()(const weight_type<element_type>& w, const element_type& x) {
+      s_->add(idx_, x, w.value);
+    }
+
+    /// Add another sketch.
+    reference& operator+=(const value_type& x) {
+      s_->merge(idx_, x);
+      return *this;
+    }
+
+    /// Scale the weights by value.
+    reference& operator*=(const element_type& x) {
+      auto tmp = operator value_type();
+      tmp *= x;
+      return operator=(tmp);
+    }
+
+    /// Return sum of weights.
+    element_type count() const noexcept { return s_->cells_[idx_].count; }
+
+    /// Return estimated quantile, see quantile_sketch::quantile().
+    element_type quantile(const element_type& q) const {
+      return operator value_type().quantile(q);
+    }
+
+    bool operator==(const value_type& rhs) const { return operator value_type() == rhs; }
+    bool operator!=(const value_type& rhs) const { return !operator==(rhs); }
+
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os, reference x) {
+      os << static_cast<value_type>(x);
+      return os;
+    }
+
+  private:
+    quantile_storage* s_;
+    std::size_t idx_;
+  };
+
+private:
+  template <class Value, class Reference, class StoragePtr>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, StoragePtr>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class P>
+    iterator_impl(const iterator_impl<V, R, P>& it) noexcept
+        : iterator_impl::iterator_adaptor_(it.base()), s_(it.s_) {}
+    iterator_impl(StoragePtr s, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), s_(s) {}
+
+    Reference operator*() const { return (*s_)[this->base()]; }
+
+    template <class V, class R, class P>
+    friend class iterator_impl;
+
+  private:
+    StoragePtr s_ = nullptr;
+  };
+
+  static constexpr std::size_t block_size = 16;
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  using centroid_type = detail::centroid<element_type>;
+
+  // centroids of a cell are in a chain of blocks, the first block holds the newest
+  // centroids and is the only one which may be partially filled
+  struct cell_type {
+    element_type count{};
+    element_type min = std::numeric_limits<element_type>::infinity();
+    element_type max = -std::numeric_limits<element_type>::infinity();
+    std::size_t head = npos;
+    std::size_t size = 0;
+  };
+
+  template <class U>
+  using rebind = typename std::allocator_traits<allocator_type>::template rebind_alloc<U>;
+
+public:
+  using iterator = iterator_impl<value_type, reference, quantile_storage*>;
+  using const_iterator =
+      iterator_impl<const value_type, const_reference, const quantile_storage*>;
+
+  /**
+    Make storage.
+
+    @param compression compression parameter of the sketches.
+    @param a allocator.
+  */
+  explicit quantile_storage(const element_type compression = 100,
+                            const allocator_type& a = {})
+      : compression_(compression)
+      , capacity_(detail::tdigest_capacity(compression))
+      , cells_(rebind<cell_type>(a))
+      , nodes_(rebind<centroid_type>(a))
+      , next_(rebind<std::size_t>(a))
+      , scratch_(rebind<centroid_type>(a)) {
+    BOOST_ASSERT(compression > 0);
+  }
+
+  /// Make storage with default compression.
+  explicit quantile_storage(const allocator_type& a) : quantile_storage(100, a) {}
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit quantile_storage(const Iterable& s, const element_type compression = 100,
+                            const allocator_type& a = {})
+      : quantile_storage(compression, a) {
+    using std::begin;
+    using std::end;
+    reset(static_cast<std::size_t>(std::distance(begin(s), end(s))));
+    std::size_t i = 0;
+    for (auto&& x : s) store(i++, x);
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  quantile_storage& operator=(const Iterable& s) {
+    *this = quantile_storage(s, compression_, get_allocator());
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(nodes_.get_allocator()); }
+
+  void reset(std::size_t n) {
+    cells_.assign(n, cell_type{});
+    nodes_.clear();
+    next_.clear();
+    free_ = npos;
+  }
+
+  std::size_t size() const noexcept { return cells_.size(); }
+
+  reference operator[](std::size_t i) noexcept { return {this, i}; }
+  const_reference operator[](std::size_t i) const { return load(i); }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size()}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size()}; }
+
+  /// Return compression parameter of the sketches.
+  element_type compression() const noexcept { return compression_; }
+
+  /// Return number of blocks in the pool, including unused blocks.
+  std::size_t blocks() const noexcept { return next_.size(); }
+
+  bool operator==(const quantile_storage& x) const {
+    return size() == x.size() && std::equal(begin(), end(), x.begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    if (size() != static_cast<std::size_t>(iterable.size())) return false;
+    return std::equal(begin(), end(), std::begin(iterable));
+  }
+
+  /// Scale the weights of all cells.
+  quantile_storage& operator*=(const double x) {
+    const auto s = static_cast<element_type>(x);
+    for (auto&& c : cells_) c.count *= s;
+    for (auto&& c : nodes_) c.weight *= s;
+    return *this;
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    ar& make_nvp("compression", compression_);
+    capacity_ = detail::tdigest_capacity(compression_);
+    std::size_t size = cells_.size();
+    ar& make_nvp("size", size);
+    if (Archive::is_loading::value) reset(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      value_type x = load(i);
+      ar& make_nvp("value", x);
+      if (Archive::is_loading::value) store(i, x);
+    }
+  }
+
+private:
+  centroid_type* block(std::size_t b) noexcept { return nodes_.data() + b * block_size; }
+  const centroid_type* block(std::size_t b) const noexcept {
+    return nodes_.data() + b * block_size;
+  }
+
+  std::size_t allocate_block() {
+    if (free_ != npos) {
+      const auto b = free_;
+      free_ = next_[b];
+      return b;
+    }
+    nodes_.resize(nodes_.size() + block_size);
+    next_.push_back(std::size_t{npos});
+    return next_.size() - 1;
+  }
+
+  void free_block(cell_type& c) noexcept {
+    const auto b = c.head;
+    c.head = next_[b];
+    next_[b] = free_;
+    free_ = b;
+  }
+
+  // calls f(block, count, offset) for each block of the cell, where offset is the
+  // position of the first centroid of the block in the order of insertion
+  template <class F>
+  void for_each_block(const cell_type& c, F f) const {
+    std::size_t pos = c.size;
+    std::size_t n = c.size % block_size ? c.size % block_size : block_size;
+    for (auto b = c.head; b != npos; b = next_[b]) {
+      pos -= n;
+      f(b, n, pos);
+      n = block_size;
+    }
+  }
+
+  void push(cell_type& c, const centroid_type& x) {
+    const auto k = c.size % block_size;
+    if (k == 0) {
+      const auto b = allocate_block();
+      next_[b] = c.head;
+      c.head = b;
+    }
+    block(c.head)[k] = x;
+    if (++c.size >= capacity_) compress(c);
+  }
+
+  // same algorithm as in quantile_sketch, the scratch buffer is reused for all cells
+  void compress(cell_type& c) {
+    scratch_.resize(c.size);
+    for_each_block(c, [this](std::size_t b, std::size_t n, std::size_t pos) {
+      std::copy(block(b), block(b) + n, scratch_.begin() + pos);
+    });
+    const auto m = detail::tdigest_compress(scratch_.data(), c.size, compression_);
+    const auto keep = (m + block_size - 1) / block_size;
+    for (auto n = (c.size + block_size - 1) / block_size; n > keep; --n) free_block(c);
+    c.size = m;
+    for_each_block(c, [this](std::size_t b, std::size_t n, std::size_t pos) {
+      std::copy(scratch_.begin() + pos, scratch_.begin() + pos + n, block(b));
+    });
+  }
+
+  void add(std::size_t i, const element_type x, const element_type w) {
+    if (w == 0) return;
+    auto& c = cells_[i];
+    c.count += w;
+    c.min = std::min(c.min, x);
+    c.max = std::max(c.max, x);
+    push(c, {x, w});
+  }
+
+  void merge(std::size_t i, const value_type& x) {
+    if (x.count_ == 0) return;
+    auto& c = cells_[i];
+    c.count += x.count_;
+    c.min = std::min(c.min, x.min_);
+    c.max = std::max(c.max, x.max_);
+    for (auto&& cx : x.centroids_) push(c, cx);
+  }
+
+  value_type load(std::size_t i) const {
+    BOOST_ASSERT(i < cells_.size());
+    const auto& c = cells_[i];
+    value_type x(compression_);
+    x.count_ = c.count;
+    x.min_ = c.min;
+    x.max_ = c.max;
+    x.centroids_.resize(c.size);
+    for_each_block(c, [&](std::size_t b, std::size_t n, std::size_t pos) {
+      std::copy(block(b), block(b) + n, x.centroids_.begin() + pos);
+    });
+    return x;
+  }
+
+  void store(std::size_t i, const value_type& x) {
+    BOOST_ASSERT(i < cells_.size());
+    auto& c = cells_[i];
+    while (c.head != npos) free_block(c);
+    c = cell_type{};
+    merge(i, x);
+  }
+
+  element_type compression_;
+  std::size_t capacity_;
+  std::vector<cell_type, rebind<cell_type>> cells_;
+  std::vector<centroid_type, rebind<centroid_type>> nodes_;
+  std::vector<std::size_t, rebind<std::size_t>> next_;
+  std::vector<centroid_type, rebind<centroid_type>> scratch_;
+  std::size_t free_ = npos;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_SELECTION_HPP
+#define BOOST_HISTOGRAM_SELECTION_HPP
+
+#include <utility>
+
+namespace boost {
+namespace histogram {
+
+/** Mask holder and type envelope.
+
+  You should not construct these directly, use the mask() helper function.
+
+  @tparam T contiguous sequence of values convertible to bool.
+*/
+template <class T>
+struct mask_type {
+  /// Access underlying value.
+  T value;
+};
+
+/** Helper function to fill only the rows for which the mask is true.
+
+  The mask must have the same length as the sequences of values.
+
+  @param t contiguous sequence of values convertible to bool.
+*/
+template <class T>
+auto mask(T&& t) noexcept {
+  return mask_type<T>{std::forward<T>(t)};
+}
+
+/** Row numbers holder and type envelope.
+
+  You should not construct these directly, use the rows() helper function.
+
+  @tparam T contiguous sequence of integral row numbers.
+*/
+template <class T>
+struct rows_type {
+  /// Access underlying value.
+  T value;
+};
+
+/** Helper function to fill only the rows with the given row numbers.
+
+  Rows are filled in the given order, a row number may appear several times. Passing a
+  row number which is not smaller than the length of the sequences of values causes a
+  throw of `std::out_of_range`.
+
+  @param t contiguous sequence of integral row numbers.
+*/
+template <class T>
+auto rows(T&& t) noexcept {
+  return rows_type<T>{std::forward<T>(t)};
+}
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,290 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_SHARDED_STORAGE_HPP
+#define BOOST_HISTOGRAM_SHARDED_STORAGE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/accumulators/thread_safe.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/detail/optional_index.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+namespace detail {
+
+// threads are numbered consecutively in the order in which they first call this
+inline unsigned this_thread_number() noexcept {
+  static std::atomic<unsigned> count{0};
+  static thread_local const unsigned k = count.fetch_add(1, std::memory_order_relaxed);
+  return k;
+}
+
+} // namespace detail
+
+/**
+  Thread-safe storage which keeps several replicas of the cells to reduce contention.
+
+  A dense storage of thread-safe counters lets all threads increment the same memory
+  locations. For histograms with few cells, the threads then mostly wait for each other
+  to get exclusive access to the cache lines of the cells. This storage keeps Shards
+  replicas of the cells which are separated by at least one cache line. Each thread
+  increments the cells in its own replica, which is chosen from the order in which the
+  threads first access a sharded_storage. Threads which share a replica still increment
+  atomically.
+
+  Reading a cell returns the sum over the replicas, so reading is slower than writing.
+  Increments from several threads are thread-safe, but assigning or scaling cells while
+  other threads fill the histogram is not.
+
+  @tparam T arithmetic type of the counters.
+  @tparam Shards number of replicas.
+  @tparam Allocator allocator for the replicas.
+*/
+template <class T, std::size_t Shards, class Allocator>
+class sharded_storage {
+  static_assert(Shards > 0, "Shards must be positive");
+
+public:
+  static constexpr bool has_threading_support = true;
+  static constexpr std::size_t shards = Shards;
+
+  using value_type = T;
+  using allocator_type = Allocator;
+  using const_reference = value_type;
+
+private:
+  using cell_type = accumulators::thread_safe<value_type>;
+  using cell_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<cell_type>;
+  using cells_type = std::vector<cell_type, cell_allocator_type>;
+
+  // common size of cache lines, replicas are padded to avoid false sharing
+  static constexpr std::size_t cache_line = 64;
+  static constexpr std::size_t cells_per_line =
+      sizeof(cell_type) < cache_line ? cache_line / sizeof(cell_type) : 1;
+
+public:
+  /// Proxy reference to a cell, which increments the replica of the calling thread.
+  class reference {
+  public:
+    reference(sharded_storage* s, std::size_t i) noexcept : s_(s), idx_(i) {}
+
+    reference(const reference&) noexcept = default;
+    reference& operator=(const reference& o) {
+      return operator=(static_cast<value_type>(o));
+    }
+
+    operator value_type() const noexcept {
+      return static_cast<const sharded_storage*>(s_)->operator[](idx_);
+    }
+
+    /// Assign value to the cell, not thread-safe.
+    reference& operator=(const value_type& x) {
+      s_->assign(idx_, x);
+      return *this;
+    }
+
+    reference& operator+=(const value_type& x) {
+      s_->local(idx_) += x;
+      return *this;
+    }
+
+    reference& operator++() {
+      ++s_->local(idx_);
+      return *this;
+    }
+
+    /// Scale the cell, not thread-safe.
+    template <class U>
+    reference& operator*=(const U& x) {
+      return operator=(static_cast<value_type>(operator value_type() * x));
+    }
+
+    /// Divide the cell, not thread-safe.
+    template <class U>
+    reference& operator/=(const U& x) {
+      return operator=(static_cast<value_type>(operator value_type() / x));
+    }
+
+    template <class U, class = std::enable_if_t<
+                           detail::has_operator_equal<value_type, U>::value>>
+    bool operator==(const U& rhs) const {
+      return operator value_type() == rhs;
+    }
+
+    template <class U, class = std::enable_if_t<
+                           detail::has_operator_equal<value_type, U>::value>>
+    bool operator!=(const U& rhs) const {
+      return !operator==(rhs);
+    }
+
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os, reference x) {
+      os << static_cast<value_type>(x);
+      return os;
+    }
+
+  private:
+    sharded_storage* s_;
+    std::size_t idx_;
+  };
+
+private:
+  template <class Value, class Reference, class StoragePtr>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, StoragePtr>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class P>
+    iterator_impl(const iterator_impl<V, R, P>& it) noexcept
+        : iterator_impl::iterator_adaptor_(it.base()), s_(it.s_) {}
+    iterator_impl(StoragePtr s, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), s_(s) {}
+
+    Reference operator*() const { return (*s_)[this->base()]; }
+
+    template <class V, class R, class P>
+    friend class iterator_impl;
+
+  private:
+    StoragePtr s_ = nullptr;
+  };
+
+public:
+  using iterator = iterator_impl<value_type, reference, sharded_storage*>;
+  using const_iterator =
+      iterator_impl<const value_type, const_reference, const sharded_storage*>;
+
+  explicit sharded_storage(const allocator_type& a = {})
+      : cells_(cell_allocator_type(a)) {}
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit sharded_storage(const Iterable& s, const allocator_type& a = {})
+      : sharded_storage(a) {
+    using std::begin;
+    using std::end;
+    reset(static_cast<std::size_t>(std::distance(begin(s), end(s))));
+    std::copy(begin(s), end(s), this->begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  sharded_storage& operator=(const Iterable& s) {
+    *this = sharded_storage(s, get_allocator());
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(cells_.get_allocator()); }
+
+  void reset(std::size_t n) {
+    stride_ = (n + 2 * cells_per_line - 1) / cells_per_line * cells_per_line;
+    cells_ = cells_type(Shards * stride_, cells_.get_allocator());
+    size_ = n;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  reference operator[](std::size_t i) noexcept { return {this, i}; }
+
+  /// Return sum of the cell over all replicas.
+  const_reference operator[](std::size_t i) const noexcept {
+    BOOST_ASSERT(i < size_);
+    value_type sum = 0;
+    for (std::size_t k = 0; k < Shards; ++k)
+      sum += cells_[k * stride_ + i].load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+
+  bool operator==(const sharded_storage& x) const noexcept {
+    return size_ == x.size_ && std::equal(begin(), end(), x.begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    if (size_ != static_cast<std::size_t>(iterable.size())) return false;
+    return std::equal(begin(), end(), std::begin(iterable));
+  }
+
+  /// Scale all cells, not thread-safe.
+  sharded_storage& operator*=(const double x) {
+    // scale the sum over the replicas, so that integral cells are rounded only once
+    const auto& self = *this;
+    for (std::size_t i = 0; i < size_; ++i)
+      assign(i, static_cast<value_type>(self[i] * x));
+    return *this;
+  }
+
+  /// Add cells of another storage of same size to the replica of the calling thread.
+  sharded_storage& operator+=(const sharded_storage& x) {
+    BOOST_ASSERT(size_ == x.size_);
+    const auto p = replica();
+    for (std::size_t i = 0; i < size_; ++i) p[i] += x[i];
+    return *this;
+  }
+
+  /// implementation detail; used by fill_n, increments the cells at valid indices
+  template <class Index>
+  void increment_n(const Index* indices, std::size_t n) {
+    // choose the replica once per batch
+    const auto p = replica();
+    for (auto end = indices + n; indices != end; ++indices)
+      if (detail::is_valid(*indices)) ++p[static_cast<std::size_t>(*indices)];
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    std::size_t size = size_;
+    ar& make_nvp("size", size);
+    if (Archive::is_loading::value) reset(size);
+    // replicas are merged when saving, loaded values go into the first replica
+    for (std::size_t i = 0; i < size_; ++i) {
+      value_type x = static_cast<const sharded_storage&>(*this)[i];
+      ar& make_nvp("value", x);
+      if (Archive::is_loading::value) cells_[i] = x;
+    }
+  }
+
+private:
+  cell_type* replica() noexcept {
+    return cells_.data() + detail::this_thread_number() % Shards * stride_;
+  }
+
+  cell_type& local(std::size_t i) noexcept {
+    BOOST_ASSERT(i < size_);
+    return replica()[i];
+  }
+
+  void assign(std::size_t i, const value_type& x) noexcept {
+    BOOST_ASSERT(i < size_);
+    for (std::size_t k = 0; k < Shards; ++k) cells_[k * stride_ + i] = k ? 0 : x;
+  }
+
+  cells_type cells_;
+  std::size_t stride_ = 0;
+  std::size_t size_ = 0;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
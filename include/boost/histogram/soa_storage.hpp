@@ -0,0 +1,271 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_SOA_STORAGE_HPP
+#define BOOST_HISTOGRAM_SOA_STORAGE_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/accumulators/mean.hpp>
+#include <boost/histogram/accumulators/weighted_mean.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/integer_sequence.hpp>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Dense storage of accumulators which keeps each data member in its own array.
+
+  A vector of weighted_sum, mean, or weighted_mean accumulators interleaves the data
+  members of the cells. Passes which need only one member of each cell, like summing the
+  values or exporting them, then read two to four times more memory than necessary. This
+  storage keeps the first member of all cells in one contiguous array, followed by the
+  array of the second member, and so on. The arrays are returned by field() and can be
+  processed with plain loops.
+
+  A reference to a cell is a copy of the accumulator, which also writes every change
+  back to the arrays. It can be used like the accumulator, but it does not see changes
+  which are made through other references to the same cell after it was created.
+
+  @tparam Accumulator weighted_sum, mean, or weighted_mean.
+  @tparam Allocator allocator for the arrays.
+*/
+template <class Accumulator, class Allocator>
+class soa_storage {
+  using fields_type =
+      decltype(unsafe_access::accumulator_fields(std::declval<Accumulator&>()));
+
+public:
+  static constexpr bool has_threading_support = false;
+  /// Number of data members of the accumulator.
+  static constexpr std::size_t fields = std::tuple_size<fields_type>::value;
+
+  using value_type = Accumulator;
+  using element_type = typename value_type::value_type;
+  using allocator_type = Allocator;
+  using const_reference = value_type;
+
+  /// Proxy reference to a cell, a copy of the accumulator which writes through.
+  class reference : public value_type {
+  public:
+    reference(soa_storage* s, std::size_t i) : value_type(s->load(i)), s_(s), idx_(i) {}
+
+    reference(const reference&) = default;
+    reference& operator=(const reference& o) {
+      return operator=(static_cast<const value_type&>(o));
+    }
+
+    reference& operator=(const value_type& x) {
+      base() = x;
+      return store();
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_radd<V, U>::value>>
+    reference& operator+=(const U& u) {
+      base() += u;
+      return store();
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_rsub<V, U>::value>>
+    reference& operator-=(const U& u) {
+      base() -= u;
+      return store();
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_rmul<V, U>::value>>
+    reference& operator*=(const U& u) {
+      base() *= u;
+      return store();
+    }
+
+    template <class U, class V = value_type,
+              class = std::enable_if_t<detail::has_operator_rdiv<V, U>::value>>
+    reference& operator/=(const U& u) {
+      base() /= u;
+      return store();
+    }
+
+    template <class V = value_type,
+              class = std::enable_if_t<detail::has_operator_preincrement<V>::value>>
+    reference& operator++() {
+      ++base();
+      return store();
+    }
+
+    template <class... Ts>
+    auto operator()(const Ts&... args)
+        -> decltype(std::declval<value_type&>()(args...), void()) {
+      base()(args...);
+      store();
+    }
+
+  private:
+    value_type& base() noexcept { return *this; }
+
+    reference& store() {
+      s_->store(idx_, *this);
+      return *this;
+    }
+
+    soa_storage* s_;
+    std::size_t idx_;
+  };
+
+private:
+  template <class Value, class Reference, class StoragePtr>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, StoragePtr>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class P>
+    iterator_impl(const iterator_impl<V, R, P>& it) noexcept
+        : iterator_impl::iterator_adaptor_(it.base()), s_(it.s_) {}
+    iterator_impl(StoragePtr s, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), s_(s) {}
+
+    Reference operator*() const { return (*s_)[this->base()]; }
+
+    template <class V, class R, class P>
+    friend class iterator_impl;
+
+  private:
+    StoragePtr s_ = nullptr;
+  };
+
+public:
+  using iterator = iterator_impl<value_type, reference, soa_storage*>;
+  using const_iterator =
+      iterator_impl<const value_type, const_reference, const soa_storage*>;
+
+  explicit soa_storage(const allocator_type& a = {}) : data_(a) {}
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit soa_storage(const Iterable& s, const allocator_type& a = {}) : soa_storage(a) {
+    using std::begin;
+    using std::end;
+    reset(static_cast<std::size_t>(std::distance(begin(s), end(s))));
+    std::size_t i = 0;
+    for (auto&& x : s) store(i++, x);
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  soa_storage& operator=(const Iterable& s) {
+    *this = soa_storage(s, get_allocator());
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return data_.get_allocator(); }
+
+  void reset(std::size_t n) {
+    data_.assign(fields * n, element_type{});
+    size_ = n;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  reference operator[](std::size_t i) { return {this, i}; }
+  const_reference operator[](std::size_t i) const { return load(i); }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+
+  /**
+    Return pointer to the array of a data member of all cells.
+
+    The order of the members is the order of serialization of the accumulator, for
+    example, field(0) are the sums of weights and field(1) the sums of weights squared of
+    weighted_sum.
+
+    @param k index of the data member.
+  */
+  const element_type* field(std::size_t k) const noexcept {
+    BOOST_ASSERT(k < fields);
+    return data_.data() + k * size_;
+  }
+
+  /// @copydoc field()
+  element_type* field(std::size_t k) noexcept {
+    BOOST_ASSERT(k < fields);
+    return data_.data() + k * size_;
+  }
+
+  bool operator==(const soa_storage& x) const noexcept {
+    return size_ == x.size_ && std::equal(data_.begin(), data_.end(), x.data_.begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    if (size_ != static_cast<std::size_t>(iterable.size())) return false;
+    return std::equal(begin(), end(), std::begin(iterable));
+  }
+
+  soa_storage& operator*=(const double x) {
+    for (std::size_t i = 0; i < size_; ++i) {
+      auto a = load(i);
+      a *= static_cast<element_type>(x);
+      store(i, a);
+    }
+    return *this;
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    std::size_t size = size_;
+    ar& make_nvp("size", size);
+    if (Archive::is_loading::value) reset(size);
+    for (std::size_t i = 0; i < size_; ++i) {
+      value_type x = load(i);
+      ar& make_nvp("value", x);
+      if (Archive::is_loading::value) store(i, x);
+    }
+  }
+
+private:
+  value_type load(std::size_t i) const {
+    BOOST_ASSERT(i < size_);
+    value_type x;
+    auto f = unsafe_access::accumulator_fields(x);
+    mp11::mp_for_each<mp11::mp_iota_c<fields>>([&](auto k) {
+      std::get<decltype(k)::value>(f) = data_[decltype(k)::value * size_ + i];
+    });
+    return x;
+  }
+
+  void store(std::size_t i, value_type x) {
+    BOOST_ASSERT(i < size_);
+    auto f = unsafe_access::accumulator_fields(x);
+    mp11::mp_for_each<mp11::mp_iota_c<fields>>([&](auto k) {
+      data_[decltype(k)::value * size_ + i] = std::get<decltype(k)::value>(f);
+    });
+  }
+
+  std::vector<element_type, allocator_type> data_;
+  std::size_t size_ = 0;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,355 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_SPARSE_STORAGE_HPP
+#define BOOST_HISTOGRAM_SPARSE_STORAGE_HPP
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/core/nvp.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/detail/iterator_adaptor.hpp>
+#include <boost/histogram/detail/optional_index.hpp>
+#include <boost/histogram/detail/sparse_reference.hpp>
+#include <boost/histogram/fwd.hpp>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace boost {
+namespace histogram {
+
+/**
+  Sparse storage which keeps only the cells that were written to.
+
+  The cells are stored in a flat hash table with open addressing and linear probing,
+  keyed by the linear cell index. Compared to a std::map or std::unordered_map adapted
+  with storage_adaptor, this needs no allocation per cell and the cells which are probed
+  together are adjacent in memory. The table is at most half full.
+
+  Like a map-based storage, it behaves like a dense storage of the nominal size, where
+  cells which are not in the table have the value `value_type{}`. Use filled() to iterate
+  only over the cells in the table.
+
+  @tparam T value type of the cells.
+  @tparam Allocator allocator for the table.
+*/
+template <class T, class Allocator>
+class sparse_storage {
+public:
+  static constexpr bool has_threading_support = false;
+
+  using value_type = T;
+  using allocator_type = Allocator;
+  using const_reference = const value_type&;
+
+  /// Cell in the hash table.
+  struct cell {
+    /// Linear index of the cell, or empty_index if the slot is free.
+    std::size_t index;
+    /// Value of the cell.
+    value_type value;
+  };
+
+private:
+  static constexpr std::size_t empty_index = detail::invalid_index;
+  static constexpr std::size_t min_capacity = 16;
+
+  using cell_allocator_type =
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<cell>;
+  using table_type = std::vector<cell, cell_allocator_type>;
+
+public:
+  using reference = detail::sparse_reference<sparse_storage, value_type>;
+
+private:
+  template <class Value, class Reference, class StoragePtr>
+  class iterator_impl : public detail::iterator_adaptor<
+                            iterator_impl<Value, Reference, StoragePtr>, std::size_t,
+                            Reference, Value> {
+  public:
+    iterator_impl() = default;
+    template <class V, class R, class P>
+    iterator_impl(const iterator_impl<V, R, P>& it) noexcept
+        : iterator_impl::iterator_adaptor_(it.base()), s_(it.s_) {}
+    iterator_impl(StoragePtr s, std::size_t i) noexcept
+        : iterator_impl::iterator_adaptor_(i), s_(s) {}
+
+    Reference operator*() const { return (*s_)[this->base()]; }
+
+    template <class V, class R, class P>
+    friend class iterator_impl;
+
+  private:
+    StoragePtr s_ = nullptr;
+  };
+
+public:
+  using iterator = iterator_impl<value_type, reference, sparse_storage*>;
+  using const_iterator =
+      iterator_impl<const value_type, const_reference, const sparse_storage*>;
+
+  /// Iterator over the cells in the table, skips free slots.
+  class filled_iterator {
+  public:
+    using value_type = cell;
+    using reference = const cell&;
+    using pointer = const cell*;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    filled_iterator() = default;
+    filled_iterator(pointer p, pointer end) noexcept : p_(p), end_(end) { skip(); }
+
+    reference operator*() const noexcept { return *p_; }
+    pointer operator->() const noexcept { return p_; }
+
+    filled_iterator& operator++() noexcept {
+      ++p_;
+      skip();
+      return *this;
+    }
+
+    filled_iterator operator++(int) noexcept {
+      auto tmp = *this;
+      operator++();
+      return tmp;
+    }
+
+    bool operator==(const filled_iterator& x) const noexcept { return p_ == x.p_; }
+    bool operator!=(const filled_iterator& x) const noexcept { return p_ != x.p_; }
+
+  private:
+    void skip() noexcept {
+      while (p_ != end_ && p_->index == empty_index) ++p_;
+    }
+
+    pointer p_ = nullptr;
+    pointer end_ = nullptr;
+  };
+
+  /// Range of cells in the table.
+  struct filled_range {
+    filled_iterator begin() const noexcept { return begin_; }
+    filled_iterator end() const noexcept { return end_; }
+    filled_iterator begin_, end_;
+  };
+
+  explicit sparse_storage(const allocator_type& a = {})
+      : table_(cell_allocator_type(a)) {}
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  explicit sparse_storage(const Iterable& s, const allocator_type& a = {})
+      : sparse_storage(a) {
+    using std::begin;
+    using std::end;
+    reset(static_cast<std::size_t>(std::distance(begin(s), end(s))));
+    std::copy(begin(s), end(s), this->begin());
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  sparse_storage& operator=(const Iterable& s) {
+    *this = sparse_storage(s, get_allocator());
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(table_.get_allocator()); }
+
+  void reset(std::size_t n) {
+    table_.clear();
+    table_.shrink_to_fit();
+    count_ = 0;
+    size_ = n;
+  }
+
+  /// Nominal number of cells.
+  std::size_t size() const noexcept { return size_; }
+
+  /// Number of cells in the table.
+  std::size_t filled_size() const noexcept { return count_; }
+
+  reference operator[](std::size_t i) noexcept { return {this, i}; }
+
+  const_reference operator[](std::size_t i) const noexcept {
+    BOOST_ASSERT(i < size_);
+    static const value_type null = value_type{};
+    auto p = find(i);
+    return p ? *p : null;
+  }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+
+  /// Range over the cells in the table in unspecified order.
+  filled_range filled() const noexcept {
+    const auto p = table_.data(), end = p + table_.size();
+    return {{p, end}, {end, end}};
+  }
+
+  bool operator==(const sparse_storage& x) const {
+    if (size_ != x.size_) return false;
+    auto contained_in = [](const sparse_storage& a, const sparse_storage& b) {
+      for (auto&& c : a.filled())
+        if (!(c.value == b[c.index])) return false;
+      return true;
+    };
+    return contained_in(*this, x) && contained_in(x, *this);
+  }
+
+  template <class Iterable, class = detail::requires_iterable<Iterable>>
+  bool operator==(const Iterable& iterable) const {
+    if (size_ != static_cast<std::size_t>(iterable.size())) return false;
+    auto it = std::begin(iterable);
+    for (auto&& x : *this)
+      if (!(x == *it++)) return false;
+    return true;
+  }
+
+  template <class V = value_type,
+            class = std::enable_if_t<detail::has_operator_rmul<V, double>::value>>
+  sparse_storage& operator*=(const double x) {
+    for (auto&& c : table_)
+      if (c.index != empty_index) c.value *= x;
+    return *this;
+  }
+
+  /// Add cells of another storage of same size, visits only its filled cells.
+  template <class V = value_type,
+            class = std::enable_if_t<detail::has_operator_radd<V, V>::value>>
+  sparse_storage& operator+=(const sparse_storage& x) {
+    BOOST_ASSERT(size_ == x.size_);
+    if (this == &x) return operator+=(sparse_storage(x));
+    reserve(count_ + x.count_);
+    for (auto&& c : x.filled()) insert(c.index) += c.value;
+    return *this;
+  }
+
+  /// implementation detail; used by fill_n, increments the cells at valid indices
+  template <class Index>
+  void increment_n(const Index* indices, std::size_t n) {
+    // grow at most once per batch, then insert without checking the load factor
+    reserve((std::min)(count_ + n, size_));
+    for (auto end = indices + n; indices != end; ++indices)
+      if (detail::is_valid(*indices))
+        ++insert_unchecked(static_cast<std::size_t>(*indices));
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar, unsigned /* version */) {
+    ar& make_nvp("size", size_);
+    std::size_t n = count_;
+    ar& make_nvp("filled_size", n);
+    if (Archive::is_loading::value) {
+      table_.clear();
+      count_ = 0;
+      reserve(n);
+      for (std::size_t k = 0; k < n; ++k) {
+        std::size_t i;
+        ar& make_nvp("index", i);
+        ar& make_nvp("value", insert_unchecked(i));
+      }
+    } else {
+      for (auto&& c : table_) {
+        if (c.index == empty_index) continue;
+        ar& make_nvp("index", c.index);
+        ar& make_nvp("value", c.value);
+      }
+    }
+  }
+
+private:
+  std::size_t slot(std::size_t i) const noexcept {
+    // Fibonacci hashing, consecutive indices are spread over the whole table
+    const auto h = static_cast<std::uint64_t>(i) * 11400714819323198485ull;
+    return static_cast<std::size_t>(h >> shift_);
+  }
+
+  std::size_t next(std::size_t k) const noexcept { return (k + 1) & (table_.size() - 1); }
+
+  value_type* find(std::size_t i) noexcept {
+    return const_cast<value_type*>(static_cast<const sparse_storage*>(this)->find(i));
+  }
+
+  const value_type* find(std::size_t i) const noexcept {
+    if (table_.empty()) return nullptr;
+    for (auto k = slot(i);; k = next(k)) {
+      const auto& c = table_[k];
+      if (c.index == i) return &c.value;
+      if (c.index == empty_index) return nullptr;
+    }
+  }
+
+  value_type& insert(std::size_t i) {
+    reserve(count_ + 1);
+    return insert_unchecked(i);
+  }
+
+  // table must have room for one more cell
+  value_type& insert_unchecked(std::size_t i) {
+    BOOST_ASSERT(i < size_);
+    BOOST_ASSERT(2 * (count_ + 1) <= table_.size());
+    for (auto k = slot(i);; k = next(k)) {
+      auto& c = table_[k];
+      if (c.index == i) return c.value;
+      if (c.index == empty_index) {
+        c.index = i;
+        ++count_;
+        return c.value;
+      }
+    }
+  }
+
+  void erase(std::size_t i) noexcept {
+    if (table_.empty()) return;
+    auto k = slot(i);
+    while (table_[k].index != i) {
+      if (table_[k].index == empty_index) return;
+      k = next(k);
+    }
+    // backward shift deletion, no tombstones needed with linear probing
+    for (auto j = next(k); table_[j].index != empty_index; j = next(j)) {
+      const auto h = slot(table_[j].index);
+      // cell j stays if its home slot lies cyclically in (k, j], else it fills the hole
+      const bool stays = k < j ? (k < h && h <= j) : (k < h || h <= j);
+      if (!stays) {
+        table_[k] = std::move(table_[j]);
+        k = j;
+      }
+    }
+    table_[k] = cell{empty_index, value_type{}};
+    --count_;
+  }
+
+  void reserve(std::size_t n) {
+    std::size_t capacity = (std::max)(table_.size(), std::size_t{min_capacity});
+    while (capacity < 2 * n) capacity *= 2;
+    if (capacity == table_.size()) return;
+    table_type old(capacity, cell{empty_index, value_type{}}, table_.get_allocator());
+    old.swap(table_);
+    shift_ = 64;
+    for (auto c = capacity; c > 1; c >>= 1) --shift_;
+    count_ = 0;
+    for (auto&& c : old)
+      if (c.index != empty_index) insert_unchecked(c.index) = std::move(c.value);
+  }
+
+  friend reference;
+
+  table_type table_;
+  std::size_t count_ = 0;
+  std::size_t size_ = 0;
+  unsigned shift_ = 64;
+};
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,165 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_STRIDED_HPP
+#define BOOST_HISTOGRAM_STRIDED_HPP
+
+#include <boost/assert.hpp>
+#include <boost/histogram/detail/span.hpp>
+#include <cstddef>
+#include <iterator>
+
+namespace boost {
+namespace histogram {
+
+/** Read-only view of values which are separated by a fixed number of bytes.
+
+  Can be passed to histogram::fill instead of a contiguous sequence of values, for
+  example, to fill from a field of an array of structs without copying the field.
+
+  You should not construct these directly, use the strided() helper function.
+
+  @tparam T value type.
+*/
+template <class T>
+class strided_span {
+public:
+  class const_iterator {
+  public:
+    using value_type = T;
+    using reference = const T&;
+    using pointer = const T*;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+
+    const_iterator() = default;
+    const_iterator(const char* ptr, std::size_t stride) noexcept
+        : ptr_(ptr), stride_(stride) {}
+
+    reference operator*() const noexcept { return *reinterpret_cast<pointer>(ptr_); }
+    pointer operator->() const noexcept { return reinterpret_cast<pointer>(ptr_); }
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    const_iterator& operator++() noexcept {
+      ptr_ += stride_;
+      return *this;
+    }
+
+    const_iterator operator++(int) noexcept {
+      auto tmp = *this;
+      ptr_ += stride_;
+      return tmp;
+    }
+
+    const_iterator& operator--() noexcept {
+      ptr_ -= stride_;
+      return *this;
+    }
+
+    const_iterator operator--(int) noexcept {
+      auto tmp = *this;
+      ptr_ -= stride_;
+      return tmp;
+    }
+
+    const_iterator& operator+=(difference_type n) noexcept {
+      ptr_ += n * static_cast<difference_type>(stride_);
+      return *this;
+    }
+
+    const_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+    const_iterator operator+(difference_type n) const noexcept {
+      auto tmp = *this;
+      return tmp += n;
+    }
+
+    friend const_iterator operator+(difference_type n, const const_iterator& x) noexcept {
+      return x + n;
+    }
+
+    const_iterator operator-(difference_type n) const noexcept {
+      auto tmp = *this;
+      return tmp -= n;
+    }
+
+    difference_type operator-(const const_iterator& x) const noexcept {
+      BOOST_ASSERT(stride_ > 0 && stride_ == x.stride_);
+      return (ptr_ - x.ptr_) / static_cast<difference_type>(stride_);
+    }
+
+    bool operator==(const const_iterator& x) const noexcept { return ptr_ == x.ptr_; }
+    bool operator!=(const const_iterator& x) const noexcept { return ptr_ != x.ptr_; }
+    bool operator<(const const_iterator& x) const noexcept { return ptr_ < x.ptr_; }
+    bool operator>(const const_iterator& x) const noexcept { return ptr_ > x.ptr_; }
+    bool operator<=(const const_iterator& x) const noexcept { return ptr_ <= x.ptr_; }
+    bool operator>=(const const_iterator& x) const noexcept { return ptr_ >= x.ptr_; }
+
+  private:
+    const char* ptr_ = nullptr;
+    std::size_t stride_ = 0;
+  };
+
+  using value_type = T;
+  using iterator = const_iterator;
+
+  /// Construct from pointer to first value, number of values, and stride in bytes.
+  strided_span(const T* ptr, std::size_t size, std::size_t stride) noexcept
+      : ptr_(reinterpret_cast<const char*>(ptr)), size_(size), stride_(stride) {
+    BOOST_ASSERT(stride > 0 && stride % alignof(T) == 0);
+  }
+
+  const_iterator begin() const noexcept { return {ptr_, stride_}; }
+  const_iterator end() const noexcept { return begin() + size_; }
+
+  /// Number of values.
+  std::size_t size() const noexcept { return size_; }
+
+  /// Distance between consecutive values in bytes.
+  std::size_t stride() const noexcept { return stride_; }
+
+private:
+  const char* ptr_;
+  std::size_t size_;
+  std::size_t stride_;
+};
+
+/** Helper function to pass values which are separated by a fixed number of bytes.
+
+  Use this to fill a histogram from a member of an array of structs, e.g.
+  `strided(&events[0].x, events.size(), sizeof(Event))`. The view can be used for axis
+  arguments, weights, and samples. The values must stay alive while the view is used.
+
+  @param ptr pointer to first value.
+  @param size number of values.
+  @param stride distance between consecutive values in bytes.
+*/
+template <class T>
+strided_span<T> strided(const T* ptr, std::size_t size, std::size_t stride) noexcept {
+  return {ptr, size, stride};
+}
+
+namespace detail {
+
+// fill accesses sequences through their data, the view has no contiguous data and
+// provides an iterator instead
+template <class T>
+auto data(const strided_span<T>& s) noexcept {
+  return s.begin();
+}
+
+// a single view passed to a 1D histogram is treated like a sequence with one view
+template <class T>
+auto make_span(const strided_span<T>& s) {
+  return dtl::span<const strided_span<T>>(&s, 1);
+}
+
+} // namespace detail
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -0,0 +1,31 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_HISTOGRAM_THREADS_HPP
+#define BOOST_HISTOGRAM_THREADS_HPP
+
+namespace boost {
+namespace histogram {
+
+/** Thread count holder and type envelope.
+
+  You should not construct these directly, use the threads() helper function.
+*/
+struct threads_type {
+  /// Access underlying value.
+  unsigned value;
+};
+
+/** Helper function to request a parallel fill with several threads.
+
+  @param n number of threads, zero means std::thread::hardware_concurrency().
+*/
+inline threads_type threads(unsigned n) noexcept { return threads_type{n}; }
+
+} // namespace histogram
+} // namespace boost
+
+#endif
@@ -11,13 +11,14 @@
 #include <algorithm>
 #include <boost/assert.hpp>
 #include <boost/config.hpp>
-#include <boost/core/alloc_construct.hpp>
 #include <boost/core/exchange.hpp>
 #include <boost/core/nvp.hpp>
 #include <boost/histogram/detail/array_wrapper.hpp>
+#include <boost/histogram/detail/buffer.hpp>
 #include <boost/histogram/detail/iterator_adaptor.hpp>
 #include <boost/histogram/detail/large_int.hpp>
 #include <boost/histogram/detail/operators.hpp>
+#include <boost/histogram/detail/optional_index.hpp>
 #include <boost/histogram/detail/safe_comparison.hpp>
 #include <boost/histogram/fwd.hpp>
 #include <boost/mp11/algorithm.hpp>
@@ -27,6 +28,7 @@
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <type_traits>
 
@@ -48,69 +50,6 @@ using if_arithmetic_or_large_int =
 template <class L, class T>
 using next_type = mp11::mp_at_c<L, (mp11::mp_find<L, T>::value + 1)>;
 
-template <class Allocator>
-class construct_guard {
-public:
-  using pointer = typename std::allocator_traits<Allocator>::pointer;
-
-  construct_guard(Allocator& a, pointer p, std::size_t n) noexcept
-      : a_(a), p_(p), n_(n) {}
-
-  ~construct_guard() {
-    if (p_) { a_.deallocate(p_, n_); }
-  }
-
-  void release() { p_ = pointer(); }
-
-  construct_guard(const construct_guard&) = delete;
-  construct_guard& operator=(const construct_guard&) = delete;
-
-private:
-  Allocator& a_;
-  pointer p_;
-  std::size_t n_;
-};
-
-template <class Allocator>
-void* buffer_create(Allocator& a, std::size_t n) {
-  auto ptr = a.allocate(n); // may throw
-  static_assert(std::is_trivially_copyable<decltype(ptr)>::value,
-                "ptr must be trivially copyable");
-  construct_guard<Allocator> guard(a, ptr, n);
-  boost::alloc_construct_n(a, ptr, n);
-  guard.release();
-  return static_cast<void*>(ptr);
-}
-
-template <class Allocator, class Iterator>
-auto buffer_create(Allocator& a, std::size_t n, Iterator iter) {
-  BOOST_ASSERT(n > 0u);
-  auto ptr = a.allocate(n); // may throw
-  static_assert(std::is_trivially_copyable<decltype(ptr)>::value,
-                "ptr must be trivially copyable");
-  construct_guard<Allocator> guard(a, ptr, n);
-  using T = typename std::allocator_traits<Allocator>::value_type;
-  struct casting_iterator {
-    void operator++() noexcept { ++iter_; }
-    T operator*() noexcept {
-      return static_cast<T>(*iter_);
-    } // silence conversion warnings
-    Iterator iter_;
-  };
-  boost::alloc_construct_n(a, ptr, n, casting_iterator{iter});
-  guard.release();
-  return ptr;
-}
-
-template <class Allocator>
-void buffer_destroy(Allocator& a, typename std::allocator_traits<Allocator>::pointer p,
-                    std::size_t n) {
-  BOOST_ASSERT(p);
-  BOOST_ASSERT(n > 0u);
-  boost::alloc_destroy_n(a, p, n);
-  a.deallocate(p, n);
-}
-
 } // namespace detail
 
 /**
@@ -493,11 +432,48 @@ public:
     return *this;
   }
 
+  /// Add cells of another storage of same size, widening counters only where needed.
+  unlimited_storage& operator+=(const unlimited_storage& x) {
+    BOOST_ASSERT(size() == x.size());
+    if (this == &x) return operator+=(unlimited_storage(x));
+    x.visit([this](const auto* xp, std::size_t n) {
+      // returns index of first cell not yet added, less than n if the buffer was upgraded
+      for (std::size_t i = 0; i < n;) i = buffer_.visit(radder(), buffer_, xp, i);
+    });
+    return *this;
+  }
+
+  /**
+    Call function once with a typed pointer to the cells and the number of cells.
+
+    The pointer type depends on the current cell type, the function must accept a pointer
+    to `std::uint8_t`, `std::uint16_t`, `std::uint32_t`, `std::uint64_t`, `large_int`,
+    and `double`. This allows one to loop over all cells without going through the proxy
+    references, which dispatch on the cell type for every access.
+
+    @param f function which accepts pointer to const cells and number of cells.
+  */
+  template <class F>
+  decltype(auto) visit(F&& f) const {
+    return buffer_.visit([&f, n = buffer_.size](const auto* p) { return f(p, n); });
+  }
+
   iterator begin() noexcept { return {&buffer_, 0}; }
   iterator end() noexcept { return {&buffer_, size()}; }
   const_iterator begin() const noexcept { return {&buffer_, 0}; }
   const_iterator end() const noexcept { return {&buffer_, size()}; }
 
+  /// implementation detail; used by fill_n, increments the cells at valid indices
+  template <class Index>
+  void increment_n(const Index* indices, std::size_t n) {
+    while (n > 0) {
+      // returns number of processed indices, less than n if the buffer was upgraded
+      const auto k = buffer_.visit(bulk_incrementor(), buffer_, indices, n);
+      indices += k;
+      n -= k;
+    }
+  }
+
   /// implementation detail; used by unit tests, not part of generic storage interface
   template <class T>
   unlimited_storage(std::size_t s, const T* p, const allocator_type& a = {})
@@ -544,6 +520,105 @@ private:
     void operator()(double* tp, buffer_type&, std::size_t i) { ++tp[i]; }
   };
 
+  struct bulk_incrementor {
+    template <class T, class Index>
+    std::size_t operator()(T* tp, buffer_type& b, const Index* indices,
+                           const std::size_t n) {
+      constexpr auto tmax = (std::numeric_limits<T>::max)();
+      // a block of at most tmax values cannot increment a cell more than tmax times,
+      // so if even the largest touched cell has room for the whole block, no cell of
+      // the block can overflow and it is incremented without checks
+      constexpr auto smax = (std::numeric_limits<std::size_t>::max)();
+      constexpr std::size_t block = tmax < smax ? static_cast<std::size_t>(tmax) : smax;
+      for (std::size_t start = 0; start < n;) {
+        const auto end = start + (std::min)(block, n - start);
+        T m = 0;
+        for (auto k = start; k != end; ++k)
+          if (detail::is_valid(indices[k]))
+            m = (std::max)(m, tp[static_cast<std::size_t>(indices[k])]);
+        if (static_cast<T>(end - start) <= tmax - m) {
+          increment(tp, indices + start, end - start);
+        } else {
+          for (auto k = start; k != end; ++k) {
+            if (!detail::is_valid(indices[k])) continue;
+            auto& x = tp[static_cast<std::size_t>(indices[k])];
+            if (x == tmax) {
+              using U = detail::next_type<typename buffer_type::types, T>;
+              b.template make<U>(b.size, tp);
+              return k;
+            }
+            ++x;
+          }
+        }
+        start = end;
+      }
+      return n;
+    }
+
+    template <class Index>
+    std::size_t operator()(large_int* tp, buffer_type&, const Index* indices,
+                           const std::size_t n) {
+      return increment(tp, indices, n);
+    }
+
+    template <class Index>
+    std::size_t operator()(double* tp, buffer_type&, const Index* indices,
+                           const std::size_t n) {
+      return increment(tp, indices, n);
+    }
+
+    template <class T, class Index>
+    static std::size_t increment(T* tp, const Index* indices, const std::size_t n) {
+      for (auto it = indices, end = indices + n; it != end; ++it)
+        if (detail::is_valid(*it)) ++tp[static_cast<std::size_t>(*it)];
+      return n;
+    }
+  };
+
+  struct radder {
+    template <class T, class U>
+    std::size_t operator()(T* tp, buffer_type& b, const U* xp, std::size_t i) {
+      constexpr bool wide_enough =
+          buffer_type::template type_index<T>() >= buffer_type::template type_index<U>();
+      return add(mp11::mp_bool<wide_enough>{}, tp, b, xp, i);
+    }
+
+    // cells are narrower than the cells of the other buffer, widen once
+    template <class T, class U>
+    static std::size_t add(std::false_type, T* tp, buffer_type& b, const U*,
+                           std::size_t i) {
+      b.template make<U>(b.size, tp);
+      return i;
+    }
+
+    template <class T, class U>
+    static std::size_t add(std::true_type, T* tp, buffer_type& b, const U* xp,
+                           std::size_t i) {
+      for (; i < b.size; ++i) {
+        if (!detail::safe_radd(tp[i], xp[i])) {
+          using TN = detail::next_type<typename buffer_type::types, T>;
+          b.template make<TN>(b.size, tp);
+          return i;
+        }
+      }
+      return i;
+    }
+
+    template <class U>
+    static std::size_t add(std::true_type, large_int* tp, buffer_type& b, const U* xp,
+                           std::size_t i) {
+      for (; i < b.size; ++i) tp[i] += xp[i];
+      return i;
+    }
+
+    template <class U>
+    static std::size_t add(std::true_type, double* tp, buffer_type& b, const U* xp,
+                           std::size_t i) {
+      for (; i < b.size; ++i) tp[i] += static_cast<double>(xp[i]);
+      return i;
+    }
+  };
+
   struct adder {
     template <class U>
     void operator()(double* tp, buffer_type&, std::size_t i, const U& x) {
@@ -8,6 +8,7 @@
 #define BOOST_HISTOGRAM_UNSAFE_ACCESS_HPP
 
 #include <boost/histogram/detail/axes.hpp>
+#include <tuple>
 #include <type_traits>
 
 namespace boost {
@@ -110,6 +111,34 @@ struct unsafe_access {
   static constexpr auto& storage_adaptor_impl(storage_adaptor<T>& storage) {
     return static_cast<typename storage_adaptor<T>::impl_type&>(storage);
   }
+
+  /**
+    Get references to the data members of weighted_sum, in the order of serialization.
+    @param acc instance of weighted_sum.
+  */
+  template <class T>
+  static auto accumulator_fields(accumulators::weighted_sum<T>& acc) noexcept {
+    return std::tie(acc.sum_of_weights_, acc.sum_of_weights_squared_);
+  }
+
+  /**
+    Get references to the data members of mean, in the order of serialization.
+    @param acc instance of mean.
+  */
+  template <class T>
+  static auto accumulator_fields(accumulators::mean<T>& acc) noexcept {
+    return std::tie(acc.sum_, acc.mean_, acc.sum_of_deltas_squared_);
+  }
+
+  /**
+    Get references to the data members of weighted_mean, in the order of serialization.
+    @param acc instance of weighted_mean.
+  */
+  template <class T>
+  static auto accumulator_fields(accumulators::weighted_mean<T>& acc) noexcept {
+    return std::tie(acc.sum_of_weights_, acc.sum_of_weights_squared_, acc.weighted_mean_,
+                    acc.sum_of_weighted_deltas_squared_);
+  }
 };
 
 } // namespace histogram
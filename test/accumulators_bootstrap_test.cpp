@@ -0,0 +1,107 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/bootstrap.hpp>
+#include <boost/histogram/accumulators/ostream.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/weight.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "is_close.hpp"
+#include "throw_exception.hpp"
+#include "utility_str.hpp"
+
+using namespace boost::histogram;
+using namespace std::literals;
+
+int main() {
+  using b_t = accumulators::bootstrap<double, 10>;
+
+  // weights are deterministic and Poisson distributed with mean 1
+  {
+    BOOST_TEST_EQ(b_t::poisson_weight(3, 2), b_t::poisson_weight(3, 2));
+    BOOST_TEST_EQ(b_t::poisson_weight(3, 2),
+                  (accumulators::bootstrap<float, 20>::poisson_weight(3, 2)));
+
+    const int n = 100000;
+    double sum = 0, sum2 = 0, zeros = 0;
+    unsigned max = 0;
+    for (int i = 0; i < n; ++i) {
+      const auto w = b_t::poisson_weight(static_cast<std::uint64_t>(i), i % 7);
+      sum += w;
+      sum2 += w * w;
+      zeros += w == 0;
+      if (w > max) max = w;
+    }
+    const auto mean = sum / n;
+    BOOST_TEST_IS_CLOSE(mean, 1, 0.01);
+    BOOST_TEST_IS_CLOSE(sum2 / n - mean * mean, 1, 0.02);
+    BOOST_TEST_IS_CLOSE(zeros / n, std::exp(-1), 0.005);
+    BOOST_TEST_GE(max, 5);
+    BOOST_TEST_LE(max, 12);
+  }
+
+  // accumulator
+  {
+    b_t a;
+    BOOST_TEST_EQ(str(a), "bootstrap(0, 0)"s);
+    BOOST_TEST_EQ(a.size(), 10);
+    BOOST_TEST_EQ(a, b_t{});
+
+    a(1);
+    a(weight(2), 2);
+    BOOST_TEST_EQ(a.value(), 3);
+    for (std::size_t i = 0; i < a.size(); ++i)
+      BOOST_TEST_EQ(a[i], b_t::poisson_weight(1, i) + 2.0 * b_t::poisson_weight(2, i));
+    BOOST_TEST_NE(a, b_t{});
+
+    b_t b;
+    b(3);
+    auto c = a;
+    c += b;
+    BOOST_TEST_EQ(c.value(), 4);
+    for (std::size_t i = 0; i < c.size(); ++i)
+      BOOST_TEST_EQ(c[i], a[i] + b_t::poisson_weight(3, i));
+
+    c = a;
+    c *= 2;
+    BOOST_TEST_EQ(c.value(), 6);
+    BOOST_TEST_EQ(c[1], 2 * a[1]);
+    BOOST_TEST_IS_CLOSE(c.variance(), 4 * a.variance(), 1e-12);
+  }
+
+  // histogram, same events give the same replicas in any order
+  {
+    const int n = 10000;
+    std::vector<int> x, event;
+    for (int i = 0; i < n; ++i) {
+      x.push_back(i % 5);
+      event.push_back(i);
+    }
+
+    auto h1 = make_histogram_with(bootstrap_storage(), axis::integer<>(0, 5));
+    for (int i = n - 1; i >= 0; --i) h1(x[i], sample(event[i]));
+    auto h2 = make_histogram_with(bootstrap_storage(), axis::integer<>(0, 5));
+    h2.fill(x, sample(event));
+    BOOST_TEST(h1 == h2);
+
+    const auto total = algorithm::sum(h1);
+    BOOST_TEST_EQ(total.value(), n);
+    // variance of a Poisson distributed number of events is the number of events
+    BOOST_TEST_IS_CLOSE(total.variance() / n, 1, 0.2);
+
+    auto h3 = make_histogram_with(bootstrap_storage(), axis::integer<>(0, 5));
+    h3.fill(x, weight(2), sample(event));
+    BOOST_TEST_EQ(h3.at(1).value(), 2 * h1.at(1).value());
+    BOOST_TEST_EQ(h3.at(1)[7], 2 * h1.at(1)[7]);
+  }
+
+  return boost::report_errors();
+}
@@ -65,5 +65,29 @@ int main() {
   BOOST_TEST_EQ(m_t(1, 2, 3) += m_t(), m_t(1, 2, 3));
   BOOST_TEST_EQ(m_t() += m_t(1, 2, 3), m_t(1, 2, 3));
 
+  // adding to itself is the same as adding a copy
+  {
+    auto x = a;
+    x += x;
+    BOOST_TEST_EQ(x, c);
+  }
+
+  // adding accumulators with different means is the same as feeding all samples
+  {
+    m_t x, y, z;
+    for (double v : {1, 2, 3, 5}) {
+      x(v);
+      z(v);
+    }
+    for (double v : {10, 14}) {
+      y(v);
+      z(v);
+    }
+    x += y;
+    BOOST_TEST_EQ(x.count(), 6);
+    BOOST_TEST_IS_CLOSE(x.value(), z.value(), 1e-12);
+    BOOST_TEST_IS_CLOSE(x.variance(), z.variance(), 1e-12);
+  }
+
   return boost::report_errors();
 }
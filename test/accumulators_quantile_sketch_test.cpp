@@ -0,0 +1,83 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/ostream.hpp>
+#include <boost/histogram/accumulators/quantile_sketch.hpp>
+#include <boost/histogram/weight.hpp>
+#include <cmath>
+#include "is_close.hpp"
+#include "throw_exception.hpp"
+#include "utility_str.hpp"
+
+using namespace boost::histogram;
+using namespace std::literals;
+
+int main() {
+  using q_t = accumulators::quantile_sketch<double>;
+
+  {
+    q_t a;
+    BOOST_TEST_EQ(a.count(), 0);
+    BOOST_TEST_EQ(a.compression(), 100);
+    BOOST_TEST(std::isnan(a.quantile(0.5)));
+    BOOST_TEST_EQ(a, q_t{});
+
+    a(2);
+    BOOST_TEST_EQ(a.quantile(0.5), 2);
+    a(weight(3), 1);
+    a(weight(0), 5);
+    BOOST_TEST_EQ(a.count(), 4);
+    BOOST_TEST_EQ(a.min(), 1);
+    BOOST_TEST_EQ(a.max(), 2);
+    BOOST_TEST_EQ(a.quantile(0), 1);
+    BOOST_TEST_EQ(a.quantile(0.25), 1);
+    BOOST_TEST_EQ(a.quantile(0.5), 1.25);
+    BOOST_TEST_EQ(a.quantile(1), 2);
+    BOOST_TEST_EQ(str(a), "quantile_sketch(4, 1, 2)"s);
+    BOOST_TEST_EQ(str(a, 30, false), "      quantile_sketch(4, 1, 2)"s);
+    BOOST_TEST_NE(a, q_t{});
+  }
+
+  // many samples, memory is bounded and quantiles are accurate
+  {
+    q_t a;
+    q_t b;
+    const int n = 100000;
+    for (int i = 0; i < n; ++i) {
+      // visit 0 .. n-1 in scrambled order
+      const double x = static_cast<double>((i * 7919L) % n);
+      if (i % 2)
+        a(x);
+      else
+        b(x);
+    }
+    BOOST_TEST_IS_CLOSE(a.quantile(0.5), 0.5 * n, 0.01 * n);
+    auto c = a;
+    c += b;
+    BOOST_TEST_EQ(c.count(), n);
+    BOOST_TEST_EQ(c.min(), 0);
+    BOOST_TEST_EQ(c.max(), n - 1);
+    BOOST_TEST_IS_CLOSE(c.quantile(0.5), 0.5 * n, 0.005 * n);
+    BOOST_TEST_IS_CLOSE(c.quantile(0.99), 0.99 * n, 0.001 * n);
+    BOOST_TEST_IS_CLOSE(c.quantile(0.001), 0.001 * n, 0.0005 * n);
+
+    // adding to itself is the same as adding a copy
+    auto d = c;
+    d += d;
+    auto e = c;
+    e += q_t(c);
+    BOOST_TEST_EQ(d, e);
+    BOOST_TEST_EQ(d.count(), 2 * n);
+    BOOST_TEST_IS_CLOSE(d.quantile(0.5), 0.5 * n, 0.005 * n);
+
+    c *= 2;
+    BOOST_TEST_EQ(c.count(), 2 * n);
+    BOOST_TEST_IS_CLOSE(c.quantile(0.5), 0.5 * n, 0.005 * n);
+  }
+
+  return boost::report_errors();
+}
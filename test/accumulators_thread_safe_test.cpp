@@ -7,6 +7,7 @@
 #include <boost/core/lightweight_test.hpp>
 #include <boost/histogram/accumulators/ostream.hpp>
 #include <boost/histogram/accumulators/thread_safe.hpp>
+#include <boost/histogram/weight.hpp>
 #include <sstream>
 #include "throw_exception.hpp"
 #include "utility_str.hpp"
@@ -15,16 +16,96 @@ using namespace boost::histogram;
 using namespace std::literals;
 
 int main() {
-  using ts_t = accumulators::thread_safe<int>;
+  {
+    using ts_t = accumulators::thread_safe<int>;
 
-  ts_t i;
-  ++i;
-  i += 1000;
+    ts_t i;
+    ++i;
+    i += 1000;
 
-  BOOST_TEST_EQ(i, 1001);
-  BOOST_TEST_EQ(str(i), "1001"s);
+    BOOST_TEST_EQ(i, 1001);
+    BOOST_TEST_EQ(str(i), "1001"s);
 
-  BOOST_TEST_EQ(ts_t{} += ts_t{}, ts_t{});
+    BOOST_TEST_EQ(ts_t{} += ts_t{}, ts_t{});
+  }
+
+  {
+    using ts_t = accumulators::thread_safe<double>;
+
+    ts_t d;
+    ++d;
+    d += 0.5;
+    BOOST_TEST_EQ(d, 1.5);
+    d *= 2;
+    BOOST_TEST_EQ(d, 3);
+    BOOST_TEST_EQ(str(d), "3"s);
+  }
+
+  {
+    using w_t = accumulators::weighted_sum<double>;
+    using ts_t = accumulators::thread_safe<w_t>;
+
+    ts_t w;
+    ++w;
+    w += weight(2);
+    BOOST_TEST_EQ(w.value(), 3);
+    BOOST_TEST_EQ(w.variance(), 5);
+    BOOST_TEST_EQ(w.load(), w_t(3, 5));
+    w += w;
+    w *= 2;
+    BOOST_TEST_EQ(w.load(), w_t(12, 40));
+    BOOST_TEST_EQ(str(w), "weighted_sum(12, 40)"s);
+
+    const ts_t w2 = w;
+    BOOST_TEST_EQ(w2, w);
+    BOOST_TEST_NE(w2, ts_t{});
+  }
+
+  {
+    using m_t = accumulators::mean<double>;
+    using ts_t = accumulators::thread_safe<m_t>;
+
+    ts_t m;
+    m_t m2;
+    for (double x : {1.0, 2.0, 4.0}) {
+      m(x);
+      m2(x);
+    }
+    m(weight(2), 3.0);
+    m2(weight(2), 3.0);
+    BOOST_TEST_EQ(m.load(), m2);
+    BOOST_TEST_EQ(m.count(), m2.count());
+    BOOST_TEST_EQ(m.value(), m2.value());
+    BOOST_TEST_EQ(m.variance(), m2.variance());
+    BOOST_TEST_EQ(str(m), str(m2));
+
+    auto m3 = m;
+    m3 += m;
+    m2 += m2;
+    BOOST_TEST_EQ(m3.load(), m2);
+    m3 *= 2;
+    m2 *= 2;
+    BOOST_TEST_EQ(m3.load(), m2);
+    BOOST_TEST_NE(m3, m);
+  }
+
+  {
+    using m_t = accumulators::weighted_mean<double>;
+    using ts_t = accumulators::thread_safe<m_t>;
+
+    ts_t m;
+    m_t m2;
+    m(weight(2), 1.0);
+    m2(weight(2), 1.0);
+    m(3.0);
+    m2(3.0);
+    BOOST_TEST_EQ(m.load(), m2);
+    BOOST_TEST_EQ(m.sum_of_weights(), 3);
+    BOOST_TEST_EQ(m.sum_of_weights_squared(), 5);
+    BOOST_TEST_EQ(m.value(), m2.value());
+    m.store(m_t{});
+    BOOST_TEST_EQ(m, ts_t{});
+  }
 
   return boost::report_errors();
 }
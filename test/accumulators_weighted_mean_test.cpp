@@ -46,5 +46,30 @@ int main() {
   BOOST_TEST_EQ(m_t(1, 2, 3, 4) += m_t(), m_t(1, 2, 3, 4));
   BOOST_TEST_EQ(m_t() += m_t(1, 2, 3, 4), m_t(1, 2, 3, 4));
 
+  // adding to itself is the same as adding a copy
+  {
+    auto x = a;
+    x += x;
+    BOOST_TEST_EQ(x, b);
+  }
+
+  // adding accumulators with different means is the same as feeding all samples
+  {
+    m_t x, y, z;
+    x(weight(0.5), 1);
+    z(weight(0.5), 1);
+    x(weight(2), 4);
+    z(weight(2), 4);
+    y(weight(1.5), 10);
+    z(weight(1.5), 10);
+    y(weight(1), 11);
+    z(weight(1), 11);
+    x += y;
+    BOOST_TEST_EQ(x.sum_of_weights(), 5);
+    BOOST_TEST_EQ(x.sum_of_weights_squared(), z.sum_of_weights_squared());
+    BOOST_TEST_IS_CLOSE(x.value(), z.value(), 1e-12);
+    BOOST_TEST_IS_CLOSE(x.variance(), z.variance(), 1e-12);
+  }
+
   return boost::report_errors();
 }
@@ -10,10 +10,12 @@
 #include <boost/histogram/axis/category.hpp>
 #include <boost/histogram/axis/ostream.hpp>
 #include <boost/histogram/axis/traits.hpp>
+#include <algorithm>
 #include <limits>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 #include "std_ostream.hpp"
 #include "throw_exception.hpp"
 #include "utility_axis.hpp"
@@ -148,6 +150,62 @@ int main() {
     BOOST_TEST_EQ(str(a), "category(5, 1, 10, options=growth)");
   }
 
+  // axis::category with hashed lookup
+  {
+    using C = axis::category<std::string, axis::null_type, axis::option::hashed_t>;
+    C a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST_EQ(a.index("A"), 0);
+
+    C b({"A", "B", "C", "B"});
+    BOOST_TEST_EQ(b.size(), 4);
+    BOOST_TEST_EQ(b.index("A"), 0);
+    BOOST_TEST_EQ(b.index("B"), 1); // first of duplicated values, like std::find
+    BOOST_TEST_EQ(b.index("C"), 2);
+    BOOST_TEST_EQ(b.index("D"), 4);
+    BOOST_TEST_EQ(str(b), "category(\"A\", \"B\", \"C\", \"B\", options=hashed)");
+
+    // same bins as the axis with linear lookup
+    BOOST_TEST_EQ(b, (axis::category<std::string, axis::null_type>({"A", "B", "C", "B"})));
+
+    auto c = C(b, 1, 3, 1);
+    BOOST_TEST_EQ(c.size(), 2);
+    BOOST_TEST_EQ(c.index("A"), 2);
+    BOOST_TEST_EQ(c.index("B"), 0);
+    BOOST_TEST_EQ(c.index("C"), 1);
+  }
+
+  // axis::category with growth and hashed lookup
+  {
+    using pii_t = std::pair<axis::index_type, axis::index_type>;
+    using C = axis::category<int, axis::null_type,
+                             decltype(axis::option::growth | axis::option::hashed)>;
+    C a;
+    std::vector<int> ref;
+    for (int i = 0; i < 10000; ++i) {
+      // values in irregular order with many duplicates
+      const int x = (i * 7919) % 3001 * 1024;
+      const auto it = std::find(ref.begin(), ref.end(), x);
+      const auto j = static_cast<axis::index_type>(it - ref.begin());
+      if (it == ref.end()) {
+        ref.push_back(x);
+        BOOST_TEST_EQ(a.update(x), pii_t(j, -1));
+      } else {
+        BOOST_TEST_EQ(a.update(x), pii_t(j, 0));
+      }
+    }
+    BOOST_TEST_EQ(a.size(), static_cast<axis::index_type>(ref.size()));
+    for (axis::index_type i = 0; i < a.size(); ++i) {
+      BOOST_TEST_EQ(a.value(i), ref[i]);
+      BOOST_TEST_EQ(a.index(ref[i]), i);
+    }
+    BOOST_TEST_EQ(a.index(1), a.size());
+
+    const auto b = a;
+    BOOST_TEST_EQ(b, a);
+    BOOST_TEST_EQ(b.index(ref.back()), a.size() - 1);
+  }
+
   // iterators
   {
     test_axis_iterator(axis::category<>({3, 1, 2}, ""), 0, 3);
@@ -20,7 +20,8 @@ std::ostream& operator<<(std::ostream& os, option::bitset<N>) {
   os << "underflow " << static_cast<bool>(N & option::underflow) << " "
      << "overflow " << static_cast<bool>(N & option::overflow) << " "
      << "circular " << static_cast<bool>(N & option::circular) << " "
-     << "growth " << static_cast<bool>(N & option::growth);
+     << "growth " << static_cast<bool>(N & option::growth) << " "
+     << "hashed " << static_cast<bool>(N & option::hashed);
   return os;
 }
 
@@ -43,6 +44,8 @@ int main() {
   BOOST_TEST(uoflow_growth.test(overflow));
   BOOST_TEST(uoflow_growth.test(growth));
   BOOST_TEST_NOT(uoflow_growth.test(circular));
+  BOOST_TEST_NOT(uoflow_growth.test(hashed));
+  BOOST_TEST((growth | hashed).test(hashed));
 
   BOOST_TEST_EQ(uoflow_growth & uoflow_growth, uoflow_growth);
   BOOST_TEST_EQ(uoflow_growth & growth, growth);
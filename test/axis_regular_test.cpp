@@ -7,9 +7,12 @@
 #include <boost/core/lightweight_test.hpp>
 #include <boost/histogram/axis/ostream.hpp>
 #include <boost/histogram/axis/regular.hpp>
+#include <cmath>
 #include <limits>
+#include <random>
 #include <sstream>
 #include <type_traits>
+#include <vector>
 #include "is_close.hpp"
 #include "std_ostream.hpp"
 #include "throw_exception.hpp"
@@ -219,6 +222,34 @@ int main() {
     BOOST_TEST_EQ(a.update(-std::numeric_limits<double>::infinity()), pii_t(-1, 0));
   }
 
+  // index_n gives same results as index
+  {
+    auto check = [](const auto& a, const auto& x) {
+      std::vector<axis::index_type> idx(x.size());
+      a.index_n(x.data(), x.size(), idx.data());
+      auto it = idx.begin();
+      for (auto&& xi : x) BOOST_TEST_EQ(*it++, a.index(xi));
+    };
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> x = {-inf, -1.0, -0.1, -0.0, 0.0, 0.1, 0.5, 0.9999, 1.0, 1.1,
+                             inf,  nan,  std::nextafter(1.0, 0.0), 0.3, 0.7, 1e300};
+    std::mt19937 gen(1);
+    std::normal_distribution<> dis(0.5, 0.5);
+    for (int i = 0; i < 1000; ++i) x.push_back(dis(gen));
+
+    check(axis::regular<>(3, 0, 1), x);
+    check(axis::regular<>(7, -0.3, 1.3), x);
+    check(axis::regular<>(1000, 0, 1), x);
+    check(axis::regular<>(4, 1, 0), x);
+    check(axis::regular<double, tr::log>(5, 0.1, 1), x);
+    check(axis::circular<>(3, 0, 1), x);
+
+    std::vector<float> xf(x.begin(), x.end());
+    check(axis::regular<float>(7, -0.3f, 1.3f), xf);
+  }
+
   // iterators
   {
     test_axis_iterator(axis::regular<>(5, 0, 1), 0, 5);
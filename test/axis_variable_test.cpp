@@ -7,7 +7,9 @@
 #include <boost/core/lightweight_test.hpp>
 #include <boost/histogram/axis/ostream.hpp>
 #include <boost/histogram/axis/variable.hpp>
+#include <algorithm>
 #include <limits>
+#include <random>
 #include <sstream>
 #include <type_traits>
 #include <vector>
@@ -156,5 +158,62 @@ int main() {
     BOOST_TEST_EQ(b.value(2), 5);
   }
 
+  // index and index_n agree with a binary search over the edges
+  {
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<> uni(-1, 1);
+    for (int nedge : {2, 3, 4, 7, 8, 9, 15, 16, 17, 100, 1000}) {
+      std::vector<double> edges(nedge);
+      for (auto&& e : edges) e = uni(rng);
+      std::sort(edges.begin(), edges.end());
+      edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+      std::vector<double> x;
+      for (int i = 0; i < 1000; ++i) x.push_back(1.1 * uni(rng));
+      x.insert(x.end(), edges.begin(), edges.end());
+      x.push_back(std::numeric_limits<double>::infinity());
+      x.push_back(-std::numeric_limits<double>::infinity());
+      x.push_back(std::numeric_limits<double>::quiet_NaN());
+
+      axis::variable<> a(edges);
+      std::vector<axis::index_type> out(x.size());
+      a.index_n(x.data(), x.size(), out.data());
+      for (std::size_t i = 0; i < x.size(); ++i) {
+        const auto ref = static_cast<axis::index_type>(
+            std::upper_bound(edges.begin(), edges.end(), x[i]) - edges.begin() - 1);
+        BOOST_TEST_EQ(a.index(x[i]), ref);
+        BOOST_TEST_EQ(out[i], ref);
+      }
+    }
+
+    // index_n with circular axis
+    axis::variable<double, axis::null_type, axis::option::circular_t> b{-1, 1, 2};
+    std::vector<double> x = {-3, -2, -1, 0, 1, 2, 3, 4, -3, -2, -1, 0, 1, 2, 3, 4, 0.5};
+    std::vector<axis::index_type> out(x.size());
+    b.index_n(x.data(), x.size(), out.data());
+    for (std::size_t i = 0; i < x.size(); ++i) BOOST_TEST_EQ(out[i], b.index(x[i]));
+  }
+
+  // lookup stays consistent after growth and reduction
+  {
+    axis::variable<double, axis::null_type, axis::option::growth_t> a{0, 1};
+    for (double x : {2.0, -3.0, 5.0, -7.0, 11.0, -13.0}) a.update(x);
+    for (axis::index_type i = 0; i < a.size(); ++i) {
+      BOOST_TEST_EQ(a.index(a.value(i)), i);
+      BOOST_TEST_EQ(a.index(a.value(i + 0.5)), i);
+    }
+    BOOST_TEST_EQ(a.index(a.value(a.size())), a.size());
+    BOOST_TEST_EQ(a.index(-100), -1);
+
+    using A = axis::variable<>;
+    const auto b = A(A({0, 1, 2, 3, 4, 5, 6, 7, 8}), 2, 8, 2);
+    BOOST_TEST_EQ(b.size(), 3);
+    BOOST_TEST_EQ(b.index(1.5), -1);
+    BOOST_TEST_EQ(b.index(2), 0);
+    BOOST_TEST_EQ(b.index(5), 1);
+    BOOST_TEST_EQ(b.index(7.5), 2);
+    BOOST_TEST_EQ(b.index(8), 3);
+  }
+
   return boost::report_errors();
 }
@@ -0,0 +1,132 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/blocked_unlimited_storage.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+using storage_type = blocked_unlimited_storage<std::allocator<char>, 4>;
+
+template <class T>
+unsigned type_index() {
+  return unlimited_storage<>::buffer_type::type_index<T>();
+}
+
+template <class Storage>
+unsigned block_type(const Storage& s, std::size_t i) {
+  auto b = s.block(i); // copy keeps cell type
+  return unsafe_access::unlimited_storage_buffer(b).type;
+}
+
+int main() {
+  BOOST_TEST(detail::is_storage<storage_type>::value);
+  BOOST_TEST(blocked_unlimited_storage<>::block_size == 4096);
+
+  // empty state
+  {
+    storage_type a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST_EQ(a.blocks(), 0);
+    BOOST_TEST(a.begin() == a.end());
+  }
+
+  // reset
+  {
+    storage_type a;
+    a.reset(10);
+    BOOST_TEST_EQ(a.size(), 10);
+    BOOST_TEST_EQ(a.blocks(), 3);
+    BOOST_TEST_EQ(a.block(0).size(), 4);
+    BOOST_TEST_EQ(a.block(2).size(), 2);
+    BOOST_TEST_EQ(std::distance(a.begin(), a.end()), 10);
+    for (auto&& x : a) BOOST_TEST_EQ(x, 0);
+    a.reset(4);
+    BOOST_TEST_EQ(a.blocks(), 1);
+  }
+
+  // counters grow only in their own block
+  {
+    storage_type a;
+    a.reset(10);
+    for (unsigned i = 0; i < 256; ++i) ++a[5];
+    ++a[9];
+    BOOST_TEST_EQ(a[5], 256);
+    BOOST_TEST_EQ(a[9], 1);
+    BOOST_TEST_EQ(block_type(a, 0), type_index<std::uint8_t>());
+    BOOST_TEST_EQ(block_type(a, 1), type_index<std::uint16_t>());
+    BOOST_TEST_EQ(block_type(a, 2), type_index<std::uint8_t>());
+
+    a[0] += (std::numeric_limits<std::uint64_t>::max)();
+    ++a[0];
+    BOOST_TEST_EQ(block_type(a, 0), type_index<storage_type::large_int>());
+    BOOST_TEST_EQ(block_type(a, 1), type_index<std::uint16_t>());
+
+    a[8] += 0.5;
+    BOOST_TEST_EQ(block_type(a, 2), type_index<double>());
+    BOOST_TEST_EQ(a[8], 0.5);
+    BOOST_TEST_EQ(a[9], 1);
+  }
+
+  // equal, copy, and scaling
+  {
+    storage_type a, b;
+    a.reset(6);
+    b.reset(6);
+    ++a[4];
+    BOOST_TEST_NOT(a == b);
+    ++b[4];
+    BOOST_TEST(a == b);
+    b.reset(5);
+    BOOST_TEST_NOT(a == b);
+
+    auto c = a;
+    BOOST_TEST(c == a);
+    c *= 2;
+    BOOST_TEST_EQ(c[4], 2);
+    BOOST_TEST_EQ(a[4], 1);
+
+    std::vector<int> v = {0, 0, 0, 0, 1, 0};
+    BOOST_TEST(a == v);
+    v[5] = 300;
+    storage_type d(v);
+    BOOST_TEST_EQ(d.size(), 6);
+    BOOST_TEST(d == v);
+    BOOST_TEST_EQ(block_type(d, 0), type_index<std::uint8_t>());
+    BOOST_TEST_EQ(block_type(d, 1), type_index<std::uint16_t>());
+  }
+
+  // used in a histogram
+  {
+    auto h = make_histogram_with(blocked_unlimited_storage<std::allocator<char>, 8>(),
+                                 axis::integer<>(0, 100));
+    auto h2 = make_histogram(axis::integer<>(0, 100));
+    std::vector<int> x(1000, 3);
+    for (int i = 0; i < 1000; ++i) x.push_back(i % 110 - 5);
+    h.fill(x);
+    h2.fill(x);
+    BOOST_TEST_EQ(algorithm::sum(h), algorithm::sum(h2));
+    for (int i = -1; i <= 100; ++i) BOOST_TEST_EQ(h.at(i), h2.at(i));
+    h += h;
+    BOOST_TEST_EQ(h.at(3), 2 * h2.at(3));
+
+    // only the block with the large count is wider
+    const auto& s = unsafe_access::storage(h);
+    for (std::size_t i = 0; i < s.blocks(); ++i)
+      BOOST_TEST_EQ(block_type(s, i) == type_index<std::uint8_t>(), i != 0);
+  }
+
+  return boost::report_errors();
+}
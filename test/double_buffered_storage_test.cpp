@@ -0,0 +1,126 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/mean.hpp>
+#include <boost/histogram/accumulators/thread_safe.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/double_buffered_storage.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/storage_adaptor.hpp>
+#include <boost/histogram/unlimited_storage.hpp>
+#include <thread>
+#include <vector>
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+int main() {
+  using counter = accumulators::thread_safe<unsigned>;
+  using buffer = dense_storage<counter>;
+
+  BOOST_TEST(detail::is_storage<double_buffered_storage<buffer>>::value);
+  BOOST_TEST(double_buffered_storage<buffer>::has_threading_support);
+  BOOST_TEST_NOT(double_buffered_storage<unlimited_storage<>>::has_threading_support);
+
+  // read, write, and swap
+  {
+    double_buffered_storage<unlimited_storage<>> a;
+    a.reset(3);
+    BOOST_TEST(a == std::vector<int>({0, 0, 0}));
+    ++a[0];
+    a[1] += 2;
+    a[2] = 3;
+    BOOST_TEST_EQ(a[1], 2);
+    BOOST_TEST(a == std::vector<int>({1, 2, 3}));
+
+    auto b = a;
+    BOOST_TEST(a == b);
+
+    const auto s = a.swap_buffers();
+    BOOST_TEST(s == std::vector<int>({1, 2, 3}));
+    BOOST_TEST(a == std::vector<int>({0, 0, 0}));
+    ++a[2];
+    BOOST_TEST(a.swap_buffers() == std::vector<int>({0, 0, 1}));
+    BOOST_TEST(a.swap_buffers() == std::vector<int>({0, 0, 0}));
+
+    // copy keeps the active buffer
+    BOOST_TEST(b == std::vector<int>({1, 2, 3}));
+    a = b;
+    BOOST_TEST(a == b);
+    a.reset(2);
+    BOOST_TEST(a == std::vector<int>({0, 0}));
+  }
+
+  // fill and take snapshots
+  {
+    auto h = make_histogram_with(double_buffered_storage<dense_storage<double>>(),
+                                 axis::integer<>(0, 3));
+    h(0);
+    h.fill(std::vector<int>({1, 1, 2, 5}));
+    h(1, weight(2));
+    auto s1 = swap_buffers(h);
+    BOOST_TEST_EQ(s1.rank(), 1);
+    BOOST_TEST_EQ(s1.at(-1), 0);
+    BOOST_TEST_EQ(s1.at(0), 1);
+    BOOST_TEST_EQ(s1.at(1), 4);
+    BOOST_TEST_EQ(s1.at(2), 1);
+    BOOST_TEST_EQ(s1.at(3), 1);
+    BOOST_TEST_EQ(algorithm::sum(h), 0);
+    h(2);
+    auto s2 = swap_buffers(h);
+    BOOST_TEST_EQ(algorithm::sum(s2), 1);
+    BOOST_TEST_EQ(s2.at(2), 1);
+
+    auto p = make_histogram_with(
+        double_buffered_storage<dense_storage<accumulators::mean<>>>(),
+        axis::integer<>(0, 3));
+    p(1, sample(2));
+    p(1, sample(4));
+    const auto sp = swap_buffers(p);
+    BOOST_TEST_EQ(sp.at(1).count(), 2);
+    BOOST_TEST_EQ(sp.at(1).value(), 3);
+  }
+
+  // no fill is lost or counted twice while other threads keep filling
+  {
+    constexpr unsigned nthreads = 4;
+    constexpr int n = 100000;
+    auto h =
+        make_histogram_with(double_buffered_storage<buffer>(), axis::integer<>(0, 4));
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (unsigned k = 0; k < nthreads; ++k)
+      threads.emplace_back([&h, k] {
+        // rounds of 100 single fills alternate with batches of 100 values
+        const std::vector<int> x(100, static_cast<int>(k));
+        for (int round = 0; round < n / 100; ++round) {
+          if (round % 2)
+            h.fill(x);
+          else
+            for (int i = 0; i < 100; ++i) h(static_cast<int>(k));
+        }
+      });
+    std::thread exporter([&] {
+      std::vector<unsigned> total(nthreads);
+      auto add = [&total](const auto& s) {
+        for (unsigned k = 0; k < total.size(); ++k)
+          total[k] += static_cast<unsigned>(s.at(static_cast<int>(k)));
+      };
+      while (!done) add(swap_buffers(h));
+      add(swap_buffers(h));
+      for (auto&& t : total) BOOST_TEST_EQ(t, n);
+    });
+    for (auto&& t : threads) t.join();
+    done = true;
+    exporter.join();
+  }
+
+  return boost::report_errors();
+}
@@ -4,6 +4,7 @@
 // (See accompanying file LICENSE_1_0.txt
 // or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#include <algorithm>
 #include <array>
 #include <boost/config.hpp>
 #include <boost/core/ignore_unused.hpp>
@@ -14,18 +15,24 @@
 #include <boost/histogram/axis/category.hpp>
 #include <boost/histogram/axis/integer.hpp>
 #include <boost/histogram/axis/ostream.hpp>
+#include <boost/histogram/axis/regular.hpp>
 #include <boost/histogram/histogram.hpp>
+#include <boost/histogram/indexed.hpp>
 #include <boost/histogram/literals.hpp>
 #include <boost/histogram/make_histogram.hpp>
 #include <boost/histogram/ostream.hpp>
+#include <boost/histogram/selection.hpp>
 #include <boost/histogram/storage_adaptor.hpp>
+#include <boost/histogram/strided.hpp>
 #include <boost/variant2/variant.hpp>
+#include <cstdint>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
 #include <vector>
+#include "is_close.hpp"
 #include "throw_exception.hpp"
 #include "utility_histogram.hpp"
 
@@ -60,6 +67,19 @@ struct axis2d {
   }
 };
 
+// samples which are filled in chunks are grouped by cell, which changes the rounding
+template <class H>
+void test_profile_is_close(const H& h1, const H& h2) {
+  BOOST_TEST_EQ(h1.size(), h2.size());
+  auto it = h2.begin();
+  for (auto&& c : h1) {
+    const auto& c2 = *it++;
+    BOOST_TEST_EQ(c.count(), c2.count());
+    BOOST_TEST_IS_CLOSE(c.value(), c2.value(), 1e-12);
+    BOOST_TEST_IS_CLOSE(c.variance(), c2.variance(), 1e-12);
+  }
+}
+
 template <class Tag>
 void run_tests(const std::vector<int>& x, const std::vector<int>& y,
                const std::vector<double>& w) {
@@ -152,6 +172,118 @@ void run_tests(const std::vector<int>& x, const std::vector<int>& y,
     BOOST_TEST_THROWS(h2.fill(x, weight(w2)), std::invalid_argument);
   }
 
+  // 1D regular axis with and without flow bins
+  {
+    using r = axis::regular<double, boost::use_default, axis::null_type>;
+    using r0 = axis::regular<double, boost::use_default, axis::null_type,
+                             axis::option::none_t>;
+    auto h = make(Tag(), r{7, 0.5, 4.5});
+    auto h2 = h;
+    for (auto&& wi : w) h(wi);
+    h2.fill(w);
+    BOOST_TEST_EQ(h, h2);
+
+    auto h3 = make(Tag(), r0{7, 0.5, 4.5});
+    auto h4 = h3;
+    for (auto&& wi : w) h3(wi);
+    h4.fill(w);
+    BOOST_TEST_EQ(h3, h4);
+  }
+
+  // 1D with integral storage, which uses sub-counters
+  {
+    auto check = [&](auto storage, auto axis) {
+      auto h = make_s(Tag(), storage, axis);
+      auto h2 = h;
+      for (auto&& xi : x) h(xi);
+      h2.fill(x);
+      BOOST_TEST_EQ(h, h2);
+      // few values, sub-counters are not used
+      for (unsigned i = 0; i < 5; ++i) h(x[i]);
+      h2.fill(std::vector<int>(x.begin(), x.begin() + 5));
+      BOOST_TEST_EQ(h, h2);
+    };
+    check(dense_storage<unsigned>(), in{-3, 4});
+    check(dense_storage<unsigned>(), in0{-3, 4});
+    check(std::vector<std::uint8_t>(), in{-3, 4}); // counts wrap around
+    check(std::array<int, 8>(), in0{-3, 4});
+  }
+
+  // 1D with accurate sums, weights are first added to partial sums per chunk
+  {
+    auto check = [&](auto axis) {
+      auto h = make_s(Tag(), dense_storage<accumulators::sum<>>(), axis);
+      auto h2 = h;
+      auto h3 = make_s(Tag(), dense_storage<double>(), axis);
+      // small weights are added to a large value, which a double cannot represent
+      h(1, weight(1e8));
+      h2(1, weight(1e8));
+      h3(1, weight(1e8));
+      std::vector<double> w1(ndata, 0.1);
+      for (unsigned i = 0; i < ndata; ++i) h(x[i], weight(w1[i]));
+      h2.fill(x, weight(w1));
+      h3.fill(x, weight(w1));
+      for (auto&& xi : x) h(xi, weight(0.5));
+      h2.fill(x, weight(0.5));
+      const double n1 = static_cast<double>(std::count(x.begin(), x.end(), 1));
+      for (int i = 0; i < 3; ++i)
+        BOOST_TEST_IS_CLOSE(h.at(i).value(), h2.at(i).value(), 1e-15 * h.at(i).value());
+      BOOST_TEST_IS_CLOSE(h2.at(1).value(), (1e8 + 0.6 * n1), 1e-7);
+      BOOST_TEST_GT(std::abs(h3.at(1) - (1e8 + 0.1 * n1)), 1e-6);
+
+      // few values, partial sums are not used
+      for (unsigned i = 0; i < 5; ++i) h(x[i], weight(w[i]));
+      h2.fill(std::vector<int>(x.begin(), x.begin() + 5),
+              weight(std::vector<double>(w.begin(), w.begin() + 5)));
+      for (int i = 0; i < 3; ++i)
+        BOOST_TEST_IS_CLOSE(h.at(i).value(), h2.at(i).value(), 1e-15 * h.at(i).value());
+    };
+    check(in{0, 3});
+    check(in0{0, 3});
+
+    // large weights cancel in one partial sum and must not wipe out the small weight
+    auto h = make_s(Tag(), dense_storage<accumulators::sum<>>(), in0{0, 1});
+    auto h2 = h;
+    const std::vector<int> x1(12, 0);
+    const std::vector<double> w1 = {1e100, 0, 0, 0, 1, 0, 0, 0, -1e100, 0, 0, 0};
+    for (unsigned i = 0; i < x1.size(); ++i) h(x1[i], weight(w1[i]));
+    h2.fill(x1, weight(w1));
+    BOOST_TEST_EQ(h.at(0).value(), 1);
+    BOOST_TEST_EQ(h2.at(0).value(), h.at(0).value());
+  }
+
+  // 1D with unlimited storage, counters become wider within one chunk
+  {
+    auto check = [&](auto axis) {
+      auto h = make_s(Tag(), unlimited_storage<>(), axis);
+      auto h2 = make_s(Tag(), std::vector<double>(), axis);
+      std::vector<int> v(70000, 1);
+      for (std::size_t i = 0; i < v.size(); i += 7) v[i] = -5; // outside of axis
+      for (std::size_t i = 0; i < v.size(); i += 11) v[i] = 2;
+      h.fill(v);
+      h2.fill(v);
+      BOOST_TEST_EQ(algorithm::sum(h), algorithm::sum(h2));
+      for (int i = 0; i < 3; ++i) BOOST_TEST_EQ(h.at(i), h2.at(i));
+      // counters are large enough now
+      h.fill(v);
+      h2.fill(v);
+      BOOST_TEST_EQ(h.at(1), h2.at(1));
+    };
+    check(in{0, 3});
+    check(in0{0, 3});
+
+    // many cells, which stay narrow during several chunks and then become wider
+    auto h = make_s(Tag(), unlimited_storage<>(), in{0, 1000});
+    auto h2 = make_s(Tag(), std::vector<double>(), in{0, 1000});
+    std::vector<int> v(70000);
+    for (std::size_t i = 0; i < v.size(); ++i) v[i] = static_cast<int>(i * 7 % 1003) - 1;
+    for (int k = 0; k < 5; ++k) {
+      h.fill(v);
+      h2.fill(v);
+      for (auto&& c : indexed(h, coverage::all)) BOOST_TEST_EQ(*c, h2[c.index()]);
+    }
+  }
+
   // 2D simple
   {
     auto h = make(Tag(), in{1, 3}, in0{1, 5});
@@ -172,6 +304,145 @@ void run_tests(const std::vector<int>& x, const std::vector<int>& y,
     BOOST_TEST_THROWS(h2.fill(bad), std::invalid_argument);
   }
 
+  // 2D with tuning, large storage is prefetched
+  {
+    auto h = make_s(Tag(), dense_storage<double>(), in{-400, 400}, in0{-100, 100});
+    for (int i = 0; i < ndata; ++i) h(x[i] * 50, y[i] * 20, weight(w[i]));
+    const auto xy = {x, y};
+    std::vector<int> x2(x), y2(y);
+    for (auto&& xi : x2) xi *= 50;
+    for (auto&& yi : y2) yi *= 20;
+    const auto xy2 = {x2, y2};
+
+    for (auto&& t : {fill_tuning{1, 0}, fill_tuning{3, 1}, fill_tuning{1000, 7},
+                     fill_tuning{ndata + 1, 64}}) {
+      auto h2 = make_s(Tag(), dense_storage<double>(), in{-400, 400}, in0{-100, 100});
+      h2.tuning(t);
+      BOOST_TEST_EQ(h2.tuning().buffer_size, t.buffer_size);
+      BOOST_TEST_EQ(h2.tuning().prefetch_distance, t.prefetch_distance);
+      h2.fill(xy2, weight(w));
+      BOOST_TEST_EQ(h, h2);
+    }
+
+    // tuning is preserved by copies and does not affect equality
+    auto h3 = make(Tag(), in{1, 3}, in0{1, 5});
+    h3.tuning(fill_tuning{10, 2});
+    auto h4 = h3;
+    BOOST_TEST_EQ(h4.tuning().buffer_size, 10);
+    BOOST_TEST_EQ(h3, make(Tag(), in{1, 3}, in0{1, 5}));
+    h4.fill(xy);
+    auto h5 = make(Tag(), in{1, 3}, in0{1, 5});
+    h5.fill(xy);
+    BOOST_TEST_EQ(h4, h5);
+
+    BOOST_TEST_THROWS(h3.tuning(fill_tuning{0, 0}), std::invalid_argument);
+  }
+
+  // 2D with strided views into an array of structs
+  {
+    struct event {
+      int x;
+      char pad;
+      int y;
+      double w;
+    };
+    std::vector<event> ev(ndata);
+    for (int i = 0; i < ndata; ++i) ev[i] = {x[i], 0, y[i], w[i]};
+    const auto sx = strided(&ev[0].x, ev.size(), sizeof(event));
+    const auto sy = strided(&ev[0].y, ev.size(), sizeof(event));
+    const auto sw = strided(&ev[0].w, ev.size(), sizeof(event));
+
+    // views are random access ranges
+    BOOST_TEST_EQ(sw.end() - sw.begin(), ndata);
+    BOOST_TEST_ALL_EQ(sw.begin(), sw.end(), w.begin(), w.end());
+    BOOST_TEST(std::vector<double>(sw.begin(), sw.end()) == w);
+    BOOST_TEST(std::vector<int>(sy.begin(), sy.end()) == y);
+    BOOST_TEST_EQ(*(sx.end() - 1), x.back());
+    BOOST_TEST(sx.begin() < sx.end());
+
+    auto h = make(Tag(), in{1, 3}, in0{1, 5});
+    auto h2 = h;
+    const auto xy = {x, y};
+    h.fill(xy, weight(w));
+    const auto sxy = {sx, sy};
+    h2.fill(sxy, weight(sw));
+    BOOST_TEST_EQ(h, h2);
+
+    // 1D with sample
+    auto h3 = make_s(Tag(), profile_storage(), in{1, 3});
+    auto h4 = h3;
+    h3.fill(x, sample(w));
+    h4.fill(sx, sample(sw));
+    test_profile_is_close(h3, h4);
+
+    // mixed with contiguous sequences and single values
+    using V = variant<int, std::vector<int>, strided_span<int>>;
+    auto h5 = h;
+    auto h6 = h;
+    const auto v1 = {V(x), V(2)};
+    h5.fill(v1);
+    const auto v2 = {V(sx), V(2)};
+    h6.fill(v2);
+    BOOST_TEST_EQ(h5, h6);
+
+    const auto bad = {sx, strided(&ev[0].y, 2, sizeof(event))};
+    BOOST_TEST_THROWS(h2.fill(bad), std::invalid_argument);
+  }
+
+  // 2D with mask and row numbers
+  {
+    std::vector<char> m(ndata);
+    std::vector<int> r;
+    for (int i = 0; i < ndata; ++i) {
+      m[i] = x[i] > 0;
+      if (m[i]) r.push_back(i);
+    }
+    r.push_back(0); // rows may repeat
+
+    auto h = make(Tag(), in{1, 3}, in0{1, 5});
+    for (auto&& i : r) h(x[i], y[i], weight(w[i]));
+    auto h2 = h;
+    h2.reset();
+    auto h3 = h2;
+    const auto xy = {x, y};
+    h2.fill(xy, weight(w), rows(r));
+    BOOST_TEST_EQ(h, h2);
+    h2.reset();
+    h2.fill(xy, weight(w), mask(m));
+    h3(x[0], y[0], weight(w[0]));
+    BOOST_TEST_EQ(h, h2 + h3);
+
+    // small buffer, growing axis, and 1D
+    for (auto&& t : {fill_tuning{}, fill_tuning{3, 0}}) {
+      auto h4 = make(Tag(), ing(), in{1, 3});
+      auto h5 = h4;
+      h4.tuning(t);
+      h4.fill(xy, mask(m));
+      for (int i = 0; i < ndata; ++i)
+        if (m[i]) h5(x[i], y[i]);
+      BOOST_TEST_EQ(h4, h5);
+
+      auto h6 = make(Tag(), in{1, 3});
+      auto h7 = h6;
+      h6.tuning(t);
+      h6.fill(x, rows(r));
+      for (auto&& i : r) h7(x[i]);
+      BOOST_TEST_EQ(h6, h7);
+    }
+
+    // profile with samples
+    auto h8 = make_s(Tag(), profile_storage(), in{1, 3});
+    auto h9 = h8;
+    h8.fill(x, sample(w), mask(m));
+    for (int i = 0; i < ndata; ++i)
+      if (m[i]) h9(x[i], sample(w[i]));
+    BOOST_TEST_EQ(h8, h9);
+
+    BOOST_TEST_THROWS(h.fill(xy, mask(std::vector<char>(3))), std::invalid_argument);
+    BOOST_TEST_THROWS(h.fill(xy, rows(std::vector<int>{ndata})), std::out_of_range);
+    BOOST_TEST_THROWS(h.fill(xy, rows(std::vector<int>{-1})), std::out_of_range);
+  }
+
   // 2D variant and weight
   {
     auto h = make(Tag(), in{1, 3}, in0{1, 5});
@@ -250,6 +521,29 @@ void run_tests(const std::vector<int>& x, const std::vector<int>& y,
     BOOST_TEST_EQ(h, h2);
   }
 
+  // 2D growing with descending values, axis grows at almost every value
+  {
+    constexpr int n = 1000;
+    std::vector<int> xd(n), yd(n);
+    for (int i = 0; i < n; ++i) {
+      xd[i] = -i;
+      yd[i] = y[i] - i / 100;
+    }
+    auto h = make(Tag(), ing(), ing());
+    auto h2 = h;
+    for (int i = 0; i < n; ++i) h(xd[i], yd[i]);
+    const auto xy = {xd, yd};
+    h2.fill(xy);
+    BOOST_TEST_EQ(h, h2);
+
+    auto h3 = make(Tag(), in(-10, 10), ing());
+    auto h4 = h3;
+    for (int i = 0; i < n; ++i) h3(x[i], xd[i]);
+    const auto xy2 = {std::vector<int>(x.begin(), x.begin() + n), xd};
+    h4.fill(xy2);
+    BOOST_TEST_EQ(h3, h4);
+  }
+
   // 2D growing with weights A
   {
     auto h = make(Tag(), in(1, 3), ing());
@@ -289,6 +583,27 @@ void run_tests(const std::vector<int>& x, const std::vector<int>& y,
     BOOST_TEST_THROWS(h.fill(bad), std::invalid_argument);
   }
 
+  // 2D growing with regular axes, which use batch indexing
+  {
+    using r = axis::regular<double, boost::use_default, axis::null_type>;
+    using r0 = axis::regular<double, boost::use_default, axis::null_type,
+                             axis::option::none_t>;
+    std::vector<double> xd(x.begin(), x.end());
+    const auto xw = {xd, w};
+
+    auto h = make(Tag(), ing(), r{7, 0.5, 4.5});
+    auto h2 = h;
+    for (unsigned i = 0; i < ndata; ++i) h(xd[i], w[i]);
+    h2.fill(xw);
+    BOOST_TEST_EQ(h, h2);
+
+    auto h3 = make(Tag(), ing(), r0{7, 0.5, 4.5});
+    auto h4 = h3;
+    for (unsigned i = 0; i < ndata; ++i) h3(xd[i], w[i]);
+    h4.fill(xw);
+    BOOST_TEST_EQ(h3, h4);
+  }
+
   // 1D profile with samples
   {
     auto h = make_s(Tag(), profile_storage(), in(1, 3));
@@ -304,7 +619,33 @@ void run_tests(const std::vector<int>& x, const std::vector<int>& y,
     h2.fill(x, sample(2), weight(w));
     h2.fill(x, sample(w), weight(2));
 
-    BOOST_TEST_EQ(h, h2);
+    test_profile_is_close(h, h2);
+  }
+
+  // 1D weighted profile with samples and weights, large chunks are grouped by cell
+  {
+    auto h = make_s(Tag(), weighted_profile_storage(), in(1, 3));
+    auto h2 = h;
+
+    for (unsigned i = 0; i < ndata; ++i) h(x[i], sample(w[i]));
+    for (unsigned i = 0; i < ndata; ++i) h(x[i], sample(w[i]), weight(w[i]));
+    for (unsigned i = 0; i < ndata; ++i) h(x[i], sample(2), weight(w[i]));
+
+    h2.fill(x, sample(w));
+    h2.fill(x, sample(w), weight(w));
+    h2.fill(x, sample(2), weight(w));
+
+    BOOST_TEST_EQ(h.size(), h2.size());
+    auto it = h2.begin();
+    for (auto&& c : h) {
+      const auto& c2 = *it++;
+      const auto sw = c.sum_of_weights();
+      const auto sw2 = c.sum_of_weights_squared();
+      BOOST_TEST_IS_CLOSE(sw, c2.sum_of_weights(), 1e-12 * sw);
+      BOOST_TEST_IS_CLOSE(sw2, c2.sum_of_weights_squared(), 1e-12 * sw2);
+      BOOST_TEST_IS_CLOSE(c.value(), c2.value(), 1e-12);
+      BOOST_TEST_IS_CLOSE(c.variance(), c2.variance(), 1e-12);
+    }
   }
 
   // 2D weighted profile with samples and weights
@@ -5,15 +5,27 @@
 // or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/mean.hpp>
 #include <boost/histogram/accumulators/thread_safe.hpp>
+#include <boost/histogram/accumulators/weighted_mean.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
 #include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/category.hpp>
 #include <boost/histogram/axis/integer.hpp>
 #include <boost/histogram/axis/ostream.hpp>
+#include <boost/histogram/axis/regular.hpp>
+#include <boost/histogram/axis/variant.hpp>
+#include <boost/histogram/indexed.hpp>
 #include <boost/histogram/ostream.hpp>
 #include <boost/histogram/storage_adaptor.hpp>
+#include <boost/histogram/unlimited_storage.hpp>
 #include <iostream>
+#include <numeric>
 #include <random>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include "is_close.hpp"
 #include "throw_exception.hpp"
 #include "utility_histogram.hpp"
 
@@ -50,6 +62,172 @@ void fill_test(const A1& a1, const A2& a2, const X& x, const Y& y) {
   BOOST_TEST_EQ(h1, h2);
 }
 
+template <class Tag, class A1, class A2, class X, class Y>
+void accumulator_fill_test(const A1& a1, const A2& a2, const X& x, const Y& y) {
+  using namespace accumulators;
+  constexpr auto shift = n_fill / 4;
+  auto run_in_threads = [](auto f) {
+    std::thread t1([&] { f(0); });
+    std::thread t2([&] { f(1); });
+    std::thread t3([&] { f(2); });
+    std::thread t4([&] { f(3); });
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+  };
+
+  // weights are small integers, so sums are exact in any order
+  auto h1 = make_s(Tag{}, dense_storage<weighted_sum<>>(), a1, a2);
+  auto h2 = make_s(Tag{}, dense_storage<thread_safe<weighted_sum<>>>(), a1, a2);
+  for (int i = 0; i < n_fill; ++i) h1(x[i], y[i], weight(i % 3));
+  run_in_threads([&](int k) {
+    for (int i = k * shift; i < (k + 1) * shift; ++i) h2(x[i], y[i], weight(i % 3));
+  });
+  for (auto&& c : indexed(h1)) {
+    const auto& c2 = h2.at(c.indices());
+    BOOST_TEST_EQ(c->value(), c2.value());
+    BOOST_TEST_EQ(c->variance(), c2.variance());
+  }
+
+  // order of samples affects rounding, so only count and mean are compared
+  auto p1 = make_s(Tag{}, dense_storage<mean<>>(), a1, a2);
+  auto p2 = make_s(Tag{}, dense_storage<thread_safe<mean<>>>(), a1, a2);
+  auto p3 = make_s(Tag{}, dense_storage<thread_safe<weighted_mean<>>>(), a1, a2);
+  for (int i = 0; i < n_fill; ++i) p1(x[i], y[i], sample(i % 5));
+  run_in_threads([&](int k) {
+    for (int i = k * shift; i < (k + 1) * shift; ++i) {
+      p2(x[i], y[i], sample(i % 5));
+      p3(x[i], y[i], sample(i % 5), weight(1));
+    }
+  });
+  for (auto&& c : indexed(p1)) {
+    const auto& c2 = p2.at(c.indices());
+    const auto& c3 = p3.at(c.indices());
+    BOOST_TEST_EQ(c->count(), c2.count());
+    BOOST_TEST_EQ(c->count(), c3.sum_of_weights());
+    BOOST_TEST_IS_CLOSE(c->value(), c2.value(), 1e-10);
+    BOOST_TEST_IS_CLOSE(c->value(), c3.value(), 1e-10);
+  }
+}
+
+template <class Tag>
+void growth_fill_test() {
+  // most values are in the axis, few make it grow while other threads keep filling
+  using c = axis::category<int, use_default, axis::option::growth_t>;
+  constexpr auto shift = n_fill / 4;
+  std::vector<int> x(n_fill);
+  for (int i = 0; i < n_fill; ++i) x[i] = i % 100 == 0 ? i : i % 4;
+
+  auto h1 = make_s(Tag{}, dense_storage<int>(), c{});
+  h1.fill(x);
+
+  auto h2 = make_s(Tag{}, dense_storage<accumulators::thread_safe<int>>(), c{});
+  auto run = [&h2, &x](int k) {
+    for (int i = k * shift; i < (k + 1) * shift; ++i) h2(x[i]);
+  };
+  std::thread t1([&] { run(0); });
+  std::thread t2([&] { run(1); });
+  std::thread t3([&] { run(2); });
+  std::thread t4([&] { run(3); });
+  t1.join();
+  t2.join();
+  t3.join();
+  t4.join();
+
+  BOOST_TEST_EQ(algorithm::sum(h2), n_fill);
+  BOOST_TEST_EQ(h2.axis().size(), h1.axis().size());
+  // order of categories depends on the order of the fills
+  for (int i = 0; i < h1.axis().size(); ++i)
+    BOOST_TEST_EQ(h1.at(i), h2.at(h2.axis().index(h1.axis().value(i))));
+}
+
+template <class Tag, class A1, class A2, class X, class Y>
+void parallel_fill_test(const A1& a1, const A2& a2, const X& x, const Y& y) {
+  std::vector<double> w(x.size());
+  std::iota(w.begin(), w.end(), 0.5);
+  auto xy = {x, y};
+
+  // unweighted, with several thread counts and the serial fallback
+  {
+    auto h1 = make_s(Tag{}, dense_storage<int>(), a1, a2);
+    h1.fill(xy);
+    for (unsigned n : {0, 1, 2, 3, 7}) {
+      auto h2 = make_s(Tag{}, dense_storage<int>(), a1, a2);
+      h2.fill(xy, threads(n));
+      BOOST_TEST_EQ(h1, h2);
+    }
+    auto h3 = make_s(Tag{}, unlimited_storage<>(), a1, a2);
+    h3.fill(xy, threads(4));
+    BOOST_TEST_EQ(h1, h3);
+  }
+
+  // weighted, result must be bit-identical to serial fill
+  {
+    auto h1 = make_s(Tag{}, dense_storage<double>(), a1, a2);
+    auto h2 = h1;
+    h1.fill(xy, weight(w));
+    h2.fill(xy, weight(w), threads(4));
+    BOOST_TEST_EQ(h1, h2);
+
+    auto h3 = h1;
+    auto h4 = h1;
+    h3.fill(xy, weight(2));
+    h4.fill(xy, weight(2), threads(4));
+    BOOST_TEST_EQ(h3, h4);
+  }
+
+  // profile, serial fill groups samples by cell, which changes the rounding
+  {
+    auto h1 = make_s(Tag{}, profile_storage(), a1, a2);
+    auto h2 = h1;
+    h1.fill(xy, sample(w));
+    h2.fill(xy, sample(w), threads(3));
+    for (auto&& c : indexed(h1, coverage::all)) {
+      const auto& c2 = h2[c.indices()];
+      BOOST_TEST_EQ(c->count(), c2.count());
+      BOOST_TEST_IS_CLOSE(c->value(), c2.value(), 1e-12 * c->value());
+      BOOST_TEST_IS_CLOSE(c->variance(), c2.variance(), 1e-12 * c->variance());
+    }
+  }
+}
+
+template <class Tag>
+void parallel_fill_peaked_test() {
+  std::vector<int> x(n_fill, 2);
+  for (unsigned i = 0; i < n_fill; i += 97) x[i] = static_cast<int>(i % 7) - 1;
+  std::vector<double> w(x.size());
+  std::iota(w.begin(), w.end(), 0.5);
+
+  // most values go to one cell, the cells of one block are still filled by one thread
+  auto h1 = make_s(Tag{}, dense_storage<double>(), axis::integer<>(0, 5));
+  auto h2 = h1;
+  h1.fill(x, weight(w));
+  for (unsigned n : {2, 3, 4, 16}) {
+    h2.reset();
+    h2.fill(x, weight(w), threads(n));
+    BOOST_TEST_EQ(h1, h2);
+  }
+}
+
+void parallel_fill_throw_test() {
+  // fewer values than threads, workers without values must not wait forever for the
+  // worker which throws
+  using V = axis::variant<axis::regular<>, axis::category<std::string>>;
+  const std::vector<V> axes = {axis::category<std::string>({"a", "b"})};
+  auto h = make_histogram_with(std::vector<int>(), axes);
+  const std::vector<double> x = {1.0};
+  BOOST_TEST_THROWS(h.fill(x), std::invalid_argument);
+  BOOST_TEST_THROWS(h.fill(x, threads(2)), std::invalid_argument);
+  BOOST_TEST_THROWS(h.fill(x, threads(4)), std::invalid_argument);
+  BOOST_TEST_EQ(algorithm::sum(h), 0);
+
+  const std::vector<std::string> y = {"a", "b", "a"};
+  h.fill(y, threads(4));
+  BOOST_TEST_EQ(h.at(0), 2);
+  BOOST_TEST_EQ(h.at(1), 1);
+}
+
 template <class T>
 void tests() {
   std::mt19937 gen(1);
@@ -64,11 +242,24 @@ void tests() {
   fill_test<T>(ig{0, 1}, i{0, 1}, vi, vj);
   fill_test<T>(i{0, 1}, ig{0, 1}, vi, vj);
   fill_test<T>(ig{0, 1}, ig{0, 1}, vi, vj);
+
+  accumulator_fill_test<T>(i{-3, 3}, i{-2, 4}, vi, vj);
+  accumulator_fill_test<T>(ig{0, 1}, ig{0, 1}, vi, vj);
+
+  growth_fill_test<T>();
+
+  using in = axis::integer<int, use_default, axis::option::none_t>;
+  parallel_fill_test<T>(i{-3, 3}, i{-2, 4}, vi, vj);
+  parallel_fill_test<T>(in{-3, 3}, i{0, 1}, vi, vj);
+  parallel_fill_test<T>(in{0, 1}, in{-5, 5}, vi, vj);
+  parallel_fill_test<T>(ig{0, 1}, i{0, 1}, vi, vj);
+  parallel_fill_peaked_test<T>();
 }
 
 int main() {
   tests<static_tag>();
   tests<dynamic_tag>();
+  parallel_fill_throw_test();
 
   return boost::report_errors();
 }
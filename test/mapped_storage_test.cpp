@@ -0,0 +1,117 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/mapped_storage.hpp>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+int main() {
+  BOOST_TEST(detail::is_storage<mapped_storage<>>::value);
+
+  const char* path = "mapped_storage_test.dat";
+
+  // anonymous memory
+  {
+    mapped_storage<> a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST(a.begin() == a.end());
+    BOOST_TEST(a.path().empty());
+    a.reset(3);
+    BOOST_TEST_EQ(a.size(), 3);
+    BOOST_TEST(a == std::vector<double>({0, 0, 0}));
+    ++a[1];
+    a[2] = 3;
+    a *= 2;
+    BOOST_TEST(a == std::vector<double>({0, 2, 6}));
+
+    auto b = a;
+    BOOST_TEST(b == a);
+    ++b[0];
+    BOOST_TEST_NOT(b == a);
+    b = std::move(a);
+    BOOST_TEST(b == std::vector<double>({0, 2, 6}));
+
+    mapped_storage<int> c(std::vector<int>({1, 2}));
+    BOOST_TEST(c == std::vector<int>({1, 2}));
+  }
+
+  // create, write, and reopen
+  {
+    {
+      mapped_storage<int> a(path);
+      BOOST_TEST_EQ(a.path(), path);
+      BOOST_TEST_EQ(a.size(), 0);
+      a.reset(4);
+      BOOST_TEST(a == std::vector<int>({0, 0, 0, 0}));
+      a[1] = 2;
+      a[3] = 5;
+      a.flush();
+
+      // copies are not backed by the file
+      auto b = a;
+      BOOST_TEST(b.path().empty());
+      ++b[0];
+      BOOST_TEST_EQ(a[0], 0);
+    }
+
+    mapped_storage<int> a(path, mapped_storage<int>::file_mode::open);
+    a.reset(4);
+    BOOST_TEST(a == std::vector<int>({0, 2, 0, 5}));
+    // later resets zero the cells
+    a.reset(4);
+    BOOST_TEST(a == std::vector<int>({0, 0, 0, 0}));
+
+    a[1] = 7;
+    a.flush();
+
+    // a failed reset keeps the file, so that it can be opened with the right size
+    mapped_storage<int> b(path, mapped_storage<int>::file_mode::open);
+    BOOST_TEST_THROWS(b.reset(5), std::invalid_argument);
+    BOOST_TEST_THROWS(b.reset(5), std::invalid_argument);
+    b.reset(4);
+    BOOST_TEST(b == std::vector<int>({0, 7, 0, 0}));
+  }
+
+  // histogram is persisted in the file
+  {
+    auto ax = axis::integer<>(0, 10);
+    std::vector<int> x;
+    for (int i = 0; i < 100; ++i) x.push_back(i % 12 - 1);
+    const auto xx = {x, x};
+    {
+      auto h = make_histogram_with(mapped_storage<>(path), ax, ax);
+      h.fill(xx);
+      BOOST_TEST_EQ(algorithm::sum(h), 100);
+    }
+    auto h = make_histogram_with(
+        mapped_storage<>(path, mapped_storage<>::file_mode::open), ax, ax);
+    auto h2 = make_histogram(ax, ax);
+    h2.fill(xx);
+    BOOST_TEST_EQ(algorithm::sum(h), 100);
+    for (int i = -1; i < 11; ++i) BOOST_TEST_EQ(h.at(i, i), h2.at(i, i));
+    h.reset();
+    BOOST_TEST_EQ(algorithm::sum(h), 0);
+
+    auto hw = make_histogram_with(mapped_storage<accumulators::weighted_sum<>>(path), ax);
+    hw.fill(x, weight(2));
+    BOOST_TEST_EQ(hw.at(3).value(), 2 * h2.at(3, 3));
+    BOOST_TEST_EQ(hw.at(3).variance(), 4 * h2.at(3, 3));
+  }
+
+  std::remove(path);
+
+  return boost::report_errors();
+}
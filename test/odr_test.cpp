@@ -8,5 +8,6 @@
 #include <boost/histogram.hpp>
 #include <boost/histogram/accumulators.hpp>
 #include <boost/histogram/axis/ostream.hpp>
+#include <boost/histogram/mapped_storage.hpp>
 #include <boost/histogram/ostream.hpp>
 #include <boost/histogram/serialization.hpp>
@@ -0,0 +1,172 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/paged_storage.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+#include <vector>
+#include "throw_exception.hpp"
+#include "utility_allocator.hpp"
+
+using namespace boost::histogram;
+
+using storage_type = paged_storage<int, 4>;
+
+int main() {
+  BOOST_TEST(detail::is_storage<paged_storage<>>::value);
+
+  // empty state
+  {
+    storage_type a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST_EQ(a.pages(), 0);
+    BOOST_TEST(a.begin() == a.end());
+  }
+
+  // reset, read, and write
+  {
+    storage_type a;
+    a.reset(10);
+    BOOST_TEST_EQ(a.size(), 10);
+    BOOST_TEST_EQ(a.pages(), 3);
+    BOOST_TEST_EQ(a.allocated_pages(), 0);
+    // reading does not allocate
+    for (auto&& x : a) BOOST_TEST_EQ(x, 0);
+    BOOST_TEST_EQ(a.allocated_pages(), 0);
+    ++a[5];
+    a[9] += 2;
+    BOOST_TEST_EQ(a.allocated_pages(), 2);
+    BOOST_TEST(a.page(0) == nullptr);
+    BOOST_TEST(a.page(1) != nullptr);
+    BOOST_TEST_EQ(a[5], 1);
+    BOOST_TEST_EQ(a[9], 2);
+    a[2] *= 2;
+    a[3] = 0;
+    BOOST_TEST_EQ(a.allocated_pages(), 2);
+    a[9] = 0;
+    BOOST_TEST_EQ(a[9], 0);
+    a.reset(4);
+    BOOST_TEST_EQ(a.pages(), 1);
+    BOOST_TEST_EQ(a.allocated_pages(), 0);
+  }
+
+  // batched increments skip invalid indices
+  {
+    storage_type a;
+    a.reset(10);
+    const detail::optional_index idx[] = {{3}, {detail::invalid_index}, {3}, {9}};
+    a.increment_n(idx, 4);
+    BOOST_TEST_EQ(a[3], 2);
+    BOOST_TEST_EQ(a[9], 1);
+    BOOST_TEST_EQ(a.allocated_pages(), 2);
+  }
+
+  // equal, copy, move, add, and scale
+  {
+    storage_type a, b;
+    a.reset(10);
+    b.reset(10);
+    BOOST_TEST(a == b);
+    ++a[1];
+    BOOST_TEST_NOT(a == b);
+    ++b[1];
+    BOOST_TEST(a == b);
+    ++b[6];
+    b[6] -= 1;
+    BOOST_TEST(a == b); // allocated page with zeros equals unallocated page
+    BOOST_TEST(a == std::vector<int>({0, 1, 0, 0, 0, 0, 0, 0, 0, 0}));
+
+    auto c = a;
+    BOOST_TEST(c == a);
+    BOOST_TEST_EQ(c.allocated_pages(), 1);
+    c += b;
+    c += c;
+    BOOST_TEST_EQ(c[1], 4);
+    BOOST_TEST_EQ(c.allocated_pages(), 2);
+    auto d = std::move(c);
+    BOOST_TEST_EQ(d[1], 4);
+    d = a;
+    BOOST_TEST(d == a);
+
+    paged_storage<double, 2> e(std::vector<int>({0, 0, 5}));
+    BOOST_TEST_EQ(e.size(), 3);
+    BOOST_TEST_EQ(e.allocated_pages(), 1);
+    BOOST_TEST_EQ(e[2], 5);
+    e *= 0.5;
+    BOOST_TEST_EQ(e[2], 2.5);
+  }
+
+  // allocator is used for pages
+  {
+    tracing_allocator_db db;
+    {
+      tracing_allocator<int> alloc(db);
+      paged_storage<int, 4, tracing_allocator<int>> a(alloc);
+      a.reset(100);
+      ++a[50];
+      ++a[51];
+      ++a[99];
+      BOOST_TEST_EQ(db.at<int>().first, 8);
+      auto b = a;
+      BOOST_TEST_EQ(db.at<int>().first, 16);
+    }
+    BOOST_TEST_EQ(db.at<int>().first, 0);
+  }
+
+#ifndef BOOST_NO_EXCEPTIONS
+  // pages which were already copied are freed when copying another page throws
+  {
+    tracing_allocator_db db;
+    {
+      using S = paged_storage<int, 4, tracing_allocator<int>>;
+      tracing_allocator<int> alloc(db);
+      S a(alloc);
+      a.reset(8);
+      ++a[0];
+      ++a[4];
+      const auto bytes = db.first;
+      // fail after the table of pages and the first page, on the second page
+      db.failure_countdown = 8;
+      BOOST_TEST_THROWS(S{a}, std::bad_alloc);
+      BOOST_TEST_EQ(db.first, bytes);
+      BOOST_TEST_EQ(a[4], 1);
+    }
+    BOOST_TEST_EQ(db.first, 0);
+  }
+#endif
+
+  // used in histograms
+  {
+    auto ax = axis::integer<>(0, 1000);
+    auto h = make_histogram_with(paged_storage<>(), ax, ax);
+    auto h2 = make_histogram(ax, ax);
+    std::vector<int> x, y;
+    for (int i = 0; i < 50000; ++i) {
+      x.push_back(i % 21 - 1);
+      y.push_back(500 + i % 13);
+    }
+    const auto xy = {x, y};
+    h.fill(xy);
+    h2.fill(xy);
+    BOOST_TEST_EQ(algorithm::sum(h), algorithm::sum(h2));
+    BOOST_TEST(h == h2);
+    // filled cells are clustered in 13 rows of 1002 cells
+    BOOST_TEST_LE(unsafe_access::storage(h).allocated_pages(), 26);
+    h += h;
+    BOOST_TEST_EQ(h.at(0, 500), 2 * h2.at(0, 500));
+
+    auto hw = make_histogram_with(paged_storage<accumulators::weighted_sum<>>(), ax);
+    hw.fill(x, weight(2));
+    BOOST_TEST_EQ(algorithm::sum(hw).value(), 2 * 50000);
+  }
+
+  return boost::report_errors();
+}
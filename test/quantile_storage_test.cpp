@@ -0,0 +1,94 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/ostream.hpp>
+#include <boost/histogram/accumulators/quantile_sketch.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/quantile_storage.hpp>
+#include <vector>
+#include "is_close.hpp"
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+int main() {
+  using q_t = accumulators::quantile_sketch<>;
+
+  BOOST_TEST(detail::is_storage<quantile_storage<>>::value);
+
+  // read and write
+  {
+    quantile_storage<> a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST(a.begin() == a.end());
+    a.reset(2);
+    BOOST_TEST(a == std::vector<q_t>(2));
+    a[0](1);
+    a[0](2);
+    a[1](weight(2), 3);
+    BOOST_TEST_EQ(a[0].count(), 2);
+    BOOST_TEST_EQ(a[1].quantile(0.5), 3);
+
+    q_t x, y;
+    x(1);
+    x(2);
+    y(weight(2), 3);
+    const auto& ca = a;
+    BOOST_TEST_EQ(ca[0], x);
+    BOOST_TEST(a == std::vector<q_t>({x, y}));
+
+    a[1] = x;
+    BOOST_TEST_EQ(ca[1], x);
+    a[1] += y;
+    x += y;
+    BOOST_TEST_EQ(ca[1], x);
+
+    quantile_storage<> b(std::vector<q_t>({x, y}));
+    BOOST_TEST_EQ(b[0], x);
+    BOOST_TEST_EQ(b[1], y);
+  }
+
+  // same results as a vector of sketches, memory comes from a bounded pool
+  {
+    std::vector<int> x;
+    std::vector<double> s;
+    for (int i = 0; i < 20000; ++i) {
+      x.push_back(i % 6 - 1);
+      s.push_back((i * 7919) % 1000);
+    }
+    auto ax = axis::integer<>(0, 4);
+
+    auto h1 = make_histogram_with(quantile_storage<>(), ax);
+    auto h2 = make_histogram_with(dense_storage<q_t>(), ax);
+    h1.fill(x, sample(s));
+    for (std::size_t i = 0; i < x.size(); ++i) h2(x[i], sample(s[i]));
+    BOOST_TEST(h1 == h2);
+    BOOST_TEST_EQ(h1.at(0).count(), 20000 / 6 + 1);
+    BOOST_TEST_IS_CLOSE(h1.at(0).quantile(0.5), 500, 10);
+    BOOST_TEST_IS_CLOSE(h1.at(0).quantile(0.99), 990, 3);
+
+    // each cell uses at most one buffer of blocks
+    const auto blocks = unsafe_access::storage(h1).blocks();
+    BOOST_TEST_LE(blocks, h1.size() * 112 / 16);
+    h1.fill(x, sample(s));
+    BOOST_TEST_EQ(unsafe_access::storage(h1).blocks(), blocks);
+
+    auto h3 = h1;
+    h3 += h1;
+    BOOST_TEST_EQ(h3.at(0).count(), 2 * h1.at(0).count());
+    BOOST_TEST_IS_CLOSE(h3.at(0).quantile(0.5), 500, 10);
+    BOOST_TEST_EQ(algorithm::sum(h1).count(), 40000);
+
+    h3 *= 0.5;
+    BOOST_TEST_EQ(h3.at(0).count(), h1.at(0).count());
+  }
+
+  return boost::report_errors();
+}
@@ -0,0 +1,132 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/category.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/sharded_storage.hpp>
+#include <thread>
+#include <vector>
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+template <class F>
+void run_in_threads(unsigned n, F f) {
+  std::vector<std::thread> threads;
+  for (unsigned k = 0; k < n; ++k) threads.emplace_back(f, k);
+  for (auto&& t : threads) t.join();
+}
+
+int main() {
+  BOOST_TEST(detail::is_storage<sharded_storage<>>::value);
+  BOOST_TEST(sharded_storage<>::has_threading_support);
+
+  // read and write
+  {
+    sharded_storage<int, 3> a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST(a.begin() == a.end());
+    a.reset(3);
+    BOOST_TEST(a == std::vector<int>({0, 0, 0}));
+    ++a[0];
+    a[1] += 2;
+    a[2] = 3;
+    BOOST_TEST_EQ(a[1], 2);
+    const auto& ca = a;
+    BOOST_TEST_EQ(ca[2], 3);
+
+    // increments from other threads go into other replicas and are merged on read
+    run_in_threads(5, [&a](unsigned) {
+      for (int i = 0; i < 100; ++i) ++a[0];
+    });
+    BOOST_TEST_EQ(ca[0], 501);
+
+    // assignment and scaling act on the merged value
+    a[0] = 2;
+    BOOST_TEST_EQ(ca[0], 2);
+    a[0] *= 2;
+    BOOST_TEST_EQ(ca[0], 4);
+    a *= 0.5;
+    BOOST_TEST(a == std::vector<int>({2, 1, 1}));
+
+    auto b = a;
+    BOOST_TEST(a == b);
+    b += a;
+    BOOST_TEST(b == std::vector<int>({4, 2, 2}));
+    b += b;
+    BOOST_TEST(b == std::vector<int>({8, 4, 4}));
+
+    sharded_storage<int, 3> c(std::vector<int>({1, 2}));
+    BOOST_TEST(c == std::vector<int>({1, 2}));
+  }
+
+  // scaling rounds the merged value of integral cells, not each replica
+  {
+    sharded_storage<int, 3> a;
+    a.reset(2);
+    // consecutive threads use different replicas
+    run_in_threads(3, [&a](unsigned) {
+      ++a[0];
+      a[1] += 3;
+    });
+    const auto& ca = a;
+    BOOST_TEST_EQ(ca[0], 3);
+    a *= 0.5;
+    BOOST_TEST(a == std::vector<int>({1, 4}));
+  }
+
+  // batched increments skip invalid indices
+  {
+    sharded_storage<> a;
+    a.reset(4);
+    const detail::optional_index idx[] = {{1}, {detail::invalid_index}, {1}, {3}};
+    a.increment_n(idx, 4);
+    BOOST_TEST(a == std::vector<int>({0, 2, 0, 1}));
+  }
+
+  // filled concurrently, with single values and with fill
+  {
+    constexpr unsigned nthreads = 6;
+    constexpr int n = 10000;
+    std::vector<int> x(n);
+    for (int i = 0; i < n; ++i) x[i] = i % 18 - 1;
+
+    auto h1 = make_histogram(axis::integer<>(0, 16));
+    h1.fill(x);
+
+    auto h2 = make_histogram_with(sharded_storage<unsigned, 4>(), axis::integer<>(0, 16));
+    run_in_threads(nthreads, [&](unsigned) {
+      for (auto&& xi : x) h2(xi);
+    });
+    BOOST_TEST_EQ(algorithm::sum(h2), nthreads * n);
+    for (auto i = -1; i < 17; ++i) BOOST_TEST_EQ(h2.at(i), nthreads * h1.at(i));
+
+    auto h3 = make_histogram_with(sharded_storage<>(), axis::integer<>(0, 16));
+    run_in_threads(nthreads, [&](unsigned) { h3.fill(x); });
+    BOOST_TEST(h2 == h3);
+
+    auto h4 = make_histogram_with(sharded_storage<>(), axis::integer<>(0, 16));
+    h4.fill(x, threads(3));
+    BOOST_TEST(h1 == h4);
+  }
+
+  // growing axis, histogram serializes growth with a mutex
+  {
+    auto h = make_histogram_with(sharded_storage<>(),
+                                 axis::category<int, use_default, axis::option::growth_t>());
+    run_in_threads(4, [&h](unsigned k) {
+      for (int i = 0; i < 1000; ++i) h(static_cast<int>(k + i % 3));
+    });
+    BOOST_TEST_EQ(h.axis().size(), 6);
+    BOOST_TEST_EQ(algorithm::sum(h), 4000);
+  }
+
+  return boost::report_errors();
+}
@@ -0,0 +1,127 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/mean.hpp>
+#include <boost/histogram/accumulators/ostream.hpp>
+#include <boost/histogram/accumulators/weighted_mean.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/indexed.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/soa_storage.hpp>
+#include <vector>
+#include "is_close.hpp"
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+int main() {
+  using wsum = accumulators::weighted_sum<>;
+  using mean = accumulators::mean<>;
+  using wmean = accumulators::weighted_mean<>;
+
+  BOOST_TEST(detail::is_storage<soa_storage<wsum>>::value);
+  BOOST_TEST(soa_storage<wsum>::fields == 2);
+  BOOST_TEST(soa_storage<mean>::fields == 3);
+  BOOST_TEST(soa_storage<wmean>::fields == 4);
+
+  // read and write
+  {
+    soa_storage<wsum> a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST(a.begin() == a.end());
+    a.reset(3);
+    BOOST_TEST(a == std::vector<wsum>(3));
+    ++a[0];
+    a[1] += weight(2);
+    a[2] = wsum(3, 4);
+    BOOST_TEST_EQ(a[1].value(), 2);
+    BOOST_TEST_EQ(a[1].variance(), 4);
+    const auto& ca = a;
+    BOOST_TEST_EQ(ca[2], wsum(3, 4));
+
+    // each data member is a contiguous array
+    const double values[] = {1, 2, 3};
+    const double variances[] = {1, 4, 4};
+    BOOST_TEST_ALL_EQ(a.field(0), a.field(0) + 3, values, values + 3);
+    BOOST_TEST_ALL_EQ(a.field(1), a.field(1) + 3, variances, variances + 3);
+
+    a *= 2;
+    BOOST_TEST_EQ(ca[2], wsum(6, 16));
+
+    auto b = a;
+    BOOST_TEST(a == b);
+    b[0] = b[1];
+    BOOST_TEST_EQ(b[0], wsum(4, 16));
+    BOOST_TEST_NOT(a == b);
+
+    soa_storage<wsum> c(std::vector<wsum>({wsum(1, 2), wsum(3, 4)}));
+    BOOST_TEST(c == std::vector<wsum>({wsum(1, 2), wsum(3, 4)}));
+  }
+
+  // references keep the accumulator interface
+  {
+    soa_storage<mean> a;
+    a.reset(2);
+    a[0](1.0);
+    a[0](3.0);
+    a[1](weight(2), 5.0);
+    auto r = a[0];
+    BOOST_TEST_EQ(r.count(), 2);
+    BOOST_TEST_EQ(r.value(), 2);
+    BOOST_TEST_EQ(r.variance(), 2);
+    r += a[1];
+    BOOST_TEST_EQ(a[0].count(), 4);
+    BOOST_TEST_EQ(a[0].value(), 3.5);
+    const double counts[] = {4, 2};
+    BOOST_TEST_ALL_EQ(a.field(0), a.field(0) + 2, counts, counts + 2);
+  }
+
+  // histogram with the same results as with a vector of accumulators
+  {
+    std::vector<int> x;
+    std::vector<double> w;
+    for (int i = 0; i < 1000; ++i) {
+      x.push_back(i % 7 - 1);
+      w.push_back(0.5 + i % 3);
+    }
+    auto ax = axis::integer<>(0, 5);
+
+    auto h1 = make_histogram_with(weight_storage(), ax);
+    auto h2 = make_histogram_with(soa_storage<wsum>(), ax);
+    h1.fill(x, weight(w));
+    h2.fill(x, weight(w));
+    for (int i = 0; i < 5; ++i) h1(i, weight(2));
+    for (int i = 0; i < 5; ++i) h2(i, weight(2));
+    BOOST_TEST(h2 == h1);
+    BOOST_TEST_EQ(algorithm::sum(h2), algorithm::sum(h1));
+    for (auto&& c : indexed(h2)) BOOST_TEST_EQ(c->value(), h1[c.index()].value());
+    h2 /= 2;
+    BOOST_TEST_EQ(h2.at(0).value(), 0.5 * h1.at(0).value());
+    BOOST_TEST_EQ(h2.at(0).variance(), 0.25 * h1.at(0).variance());
+
+    auto p1 = make_histogram_with(weighted_profile_storage(), ax);
+    auto p2 = make_histogram_with(soa_storage<wmean>(), ax);
+    for (std::size_t i = 0; i < x.size(); ++i) p1(x[i], sample(w[i]), weight(w[i]));
+    p2.fill(x, sample(w), weight(w));
+    for (auto&& c : indexed(p2, coverage::all)) {
+      const auto& c1 = p1[c.index()];
+      BOOST_TEST_EQ(c->sum_of_weights(), c1.sum_of_weights());
+      BOOST_TEST_IS_CLOSE(c->value(), c1.value(), 1e-12);
+      BOOST_TEST_IS_CLOSE(c->variance(), c1.variance(), 1e-12);
+    }
+
+    auto p3 = p2;
+    p3 += p2;
+    BOOST_TEST_EQ(p3.at(0).sum_of_weights(), 2 * p2.at(0).sum_of_weights());
+    BOOST_TEST_IS_CLOSE(p3.at(0).value(), p2.at(0).value(), 1e-12);
+  }
+
+  return boost::report_errors();
+}
@@ -0,0 +1,171 @@
+// Copyright 2019 Hans Dembinski
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <boost/core/lightweight_test.hpp>
+#include <boost/histogram/accumulators/weighted_sum.hpp>
+#include <boost/histogram/algorithm/sum.hpp>
+#include <boost/histogram/axis/integer.hpp>
+#include <boost/histogram/detail/detect.hpp>
+#include <boost/histogram/make_histogram.hpp>
+#include <boost/histogram/sparse_storage.hpp>
+#include <boost/histogram/unsafe_access.hpp>
+#include <map>
+#include <random>
+#include <vector>
+#include "throw_exception.hpp"
+
+using namespace boost::histogram;
+
+int main() {
+  BOOST_TEST(detail::is_storage<sparse_storage<>>::value);
+
+  // empty state
+  {
+    sparse_storage<> a;
+    BOOST_TEST_EQ(a.size(), 0);
+    BOOST_TEST_EQ(a.filled_size(), 0);
+    BOOST_TEST(a.begin() == a.end());
+    BOOST_TEST(a.filled().begin() == a.filled().end());
+  }
+
+  // reset, read, and write
+  {
+    sparse_storage<> a;
+    a.reset(1000000000);
+    BOOST_TEST_EQ(a.size(), 1000000000);
+    BOOST_TEST_EQ(a.filled_size(), 0);
+    const auto& ca = a;
+    BOOST_TEST_EQ(ca[5], 0);
+    ++a[5];
+    a[7] += 2;
+    a[999999999] = 3;
+    BOOST_TEST_EQ(a.filled_size(), 3);
+    BOOST_TEST_EQ(ca[5], 1);
+    BOOST_TEST_EQ(ca[7], 2);
+    BOOST_TEST_EQ(ca[999999999], 3);
+    BOOST_TEST_EQ(a[6], 0);
+    BOOST_TEST_EQ(a.filled_size(), 3);
+    a[7] *= 2;
+    a[8] *= 2;
+    BOOST_TEST_EQ(a[7], 4);
+    BOOST_TEST_EQ(a.filled_size(), 3);
+    // assigning zero removes the cell
+    a[7] = 0;
+    BOOST_TEST_EQ(a.filled_size(), 2);
+    BOOST_TEST_EQ(a[7], 0);
+    double sum = 0;
+    for (auto&& c : a.filled()) sum += c.value;
+    BOOST_TEST_EQ(sum, 4);
+    a.reset(10);
+    BOOST_TEST_EQ(a.filled_size(), 0);
+    BOOST_TEST_EQ(std::distance(a.begin(), a.end()), 10);
+  }
+
+  // assigning a cell to another cell, when the assignment grows the table
+  {
+    sparse_storage<> a;
+    a.reset(1000);
+    for (int i = 0; i < 8; ++i) a[i] = i + 1;
+    a[100] = a[3];
+    BOOST_TEST_EQ(a.filled_size(), 9);
+    BOOST_TEST_EQ(a[100], 4);
+    BOOST_TEST_EQ(a[3], 4);
+  }
+
+  // many insertions and deletions, compared with std::map
+  {
+    sparse_storage<int> a;
+    std::map<std::size_t, int> m;
+    a.reset(1000);
+    std::default_random_engine gen(1);
+    std::uniform_int_distribution<std::size_t> dis(0, 999);
+    for (int i = 0; i < 10000; ++i) {
+      const auto k = dis(gen);
+      if (i % 3 == 0) {
+        a[k] = 0;
+        m.erase(k);
+      } else {
+        ++a[k];
+        ++m[k];
+      }
+    }
+    BOOST_TEST_EQ(a.filled_size(), m.size());
+    for (std::size_t i = 0; i < 1000; ++i) {
+      const auto it = m.find(i);
+      BOOST_TEST_EQ(a[i], it == m.end() ? 0 : it->second);
+    }
+  }
+
+  // batched increments skip invalid indices
+  {
+    sparse_storage<> a;
+    a.reset(100);
+    const detail::optional_index idx[] = {{3}, {detail::invalid_index}, {3}, {99}};
+    a.increment_n(idx, 4);
+    BOOST_TEST_EQ(a.filled_size(), 2);
+    BOOST_TEST_EQ(a[3], 2);
+    BOOST_TEST_EQ(a[99], 1);
+  }
+
+  // equal, copy, add, and scale
+  {
+    sparse_storage<> a, b;
+    a.reset(5);
+    b.reset(5);
+    BOOST_TEST(a == b);
+    ++a[1];
+    BOOST_TEST_NOT(a == b);
+    ++b[1];
+    BOOST_TEST(a == b);
+    ++b[2];
+    b[2] -= 1;
+    BOOST_TEST(a == b); // cell with zero value equals missing cell
+    BOOST_TEST(a == std::vector<double>({0, 1, 0, 0, 0}));
+
+    auto c = a;
+    c += b;
+    c += c;
+    BOOST_TEST_EQ(c[1], 4);
+    c *= 0.5;
+    BOOST_TEST_EQ(c[1], 2);
+    BOOST_TEST_EQ(a[1], 1);
+
+    sparse_storage<> d(std::vector<int>({0, 0, 5}));
+    BOOST_TEST_EQ(d.size(), 3);
+    BOOST_TEST_EQ(d.filled_size(), 1);
+    BOOST_TEST_EQ(d[2], 5);
+  }
+
+  // used in histograms
+  {
+    auto ax = axis::integer<>(0, 1000);
+    auto h = make_histogram_with(sparse_storage<>(), ax, ax);
+    auto h2 = make_histogram(ax, ax);
+    std::vector<int> x, y;
+    for (int i = 0; i < 50000; ++i) {
+      x.push_back(i % 21 - 1);
+      y.push_back(i % 13 * 80);
+    }
+    const auto xy = {x, y};
+    h.fill(xy);
+    h2.fill(xy);
+    BOOST_TEST_EQ(algorithm::sum(h), algorithm::sum(h2));
+    BOOST_TEST_EQ(unsafe_access::storage(h).filled_size(), 21 * 13);
+    for (int i = -1; i < 21; ++i)
+      for (int j = 0; j < 1000; j += 80) BOOST_TEST_EQ(h.at(i, j), h2.at(i, j));
+    h += h;
+    BOOST_TEST_EQ(h.at(0, 0), 2 * h2.at(0, 0));
+
+    auto hw = make_histogram_with(sparse_storage<accumulators::weighted_sum<>>(), ax);
+    hw.fill(x, weight(2));
+    const auto& chw = hw;
+    BOOST_TEST_EQ(chw.at(3).value(), 2 * std::count(x.begin(), x.end(), 3));
+    BOOST_TEST_EQ(algorithm::sum(hw).value(), 2 * 50000);
+  }
+
+  return boost::report_errors();
+}
@@ -117,6 +117,23 @@ void increase_and_grow() {
   BOOST_TEST_EQ(n2[1], 0.0);
 }
 
+template <typename T>
+void increment_n_and_grow() {
+  auto tmax = limits_max<T>();
+  auto s = prepare(3, tmax);
+  auto ref = s;
+  // invalid indices are skipped
+  using detail::optional_index;
+  const optional_index idx[] = {{0}, {2}, {detail::invalid_index}, {0}, {2}, {0}};
+  s.increment_n(idx, 6);
+  for (auto&& i : idx)
+    if (detail::is_valid(i)) ++ref[i];
+  BOOST_TEST_EQ(s[0], static_cast<double>(tmax) + 3);
+  BOOST_TEST_EQ(s[1], 0);
+  BOOST_TEST_EQ(s[2], 2);
+  BOOST_TEST(s == ref);
+}
+
 template <typename T>
 void convert_foreign_storage() {
 
@@ -298,6 +315,11 @@ int main() {
     increase_and_grow<uint32_t>();
     increase_and_grow<uint64_t>();
 
+    increment_n_and_grow<uint8_t>();
+    increment_n_and_grow<uint16_t>();
+    increment_n_and_grow<uint32_t>();
+    increment_n_and_grow<uint64_t>();
+
     // only increase for large_int
     auto a = prepare<large_int>(2, static_cast<large_int>(1));
     BOOST_TEST_EQ(a[0], 1);
@@ -341,6 +363,45 @@ int main() {
     }
   }
 
+  // add whole storage
+  {
+    auto a = prepare(3);
+    auto b = prepare(3);
+    a[0] = 200;
+    a[1] = 1;
+    b[0] = 100;
+    b[2] = limits_max<uint64_t>();
+    a += b;
+    BOOST_TEST_EQ(a[0], 300);
+    BOOST_TEST_EQ(a[1], 1);
+    BOOST_TEST_EQ(a[2], limits_max<uint64_t>());
+    a += a;
+    BOOST_TEST_EQ(a[0], 600);
+    BOOST_TEST_EQ(a[1], 2);
+    BOOST_TEST_EQ(a[2], 2.0 * limits_max<uint64_t>());
+    auto c = prepare(3);
+    c[1] = 0.5;
+    c += a;
+    BOOST_TEST_EQ(c[0], 600);
+    BOOST_TEST_EQ(c[1], 2.5);
+    a += c;
+    BOOST_TEST_EQ(a[0], 1200);
+    BOOST_TEST_EQ(a[1], 4.5);
+  }
+
+  // visit
+  {
+    auto a = prepare(3);
+    a[1] = 300;
+    const auto x = a.visit([](const auto* p, std::size_t n) {
+      BOOST_TEST_EQ(sizeof(*p), 2);
+      double sum = 0;
+      for (auto end = p + n; p != end; ++p) sum += static_cast<double>(*p);
+      return sum;
+    });
+    BOOST_TEST_EQ(x, 300);
+  }
+
   // multiply
   {
     auto a = prepare(2);